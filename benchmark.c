@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "simulador.h"
+
+// Benchmark de eficiência estatística: executa uma grade de valores de rho e de
+// opções do simulador (gerador de números aleatórios e modo de estimação) e, para
+// cada combinação, mede a precisão relativa do IC de cada métrica (precisao_IC) e
+// o tempo de CPU consumido.
+//
+// A eficiência é medida pela variância relativa da estimativa de cada métrica,
+// calculada diretamente das médias das rodadas usadas nos ICs: v = s^2/(n*media^2),
+// onde s^2 é a variância amostral das n médias. Como v cai com 1/tempo, v * tempo
+// (a variância normalizada pelo trabalho) não depende da duração da simulação e
+// permite comparar as opções: quanto menor, menos CPU é preciso para atingir uma
+// precisão alvo. Uma precisão p_alvo exige aproximadamente Z^2*(v * tempo)/p_alvo^2
+// segundos.
+//
+// A precisão de precisao_IC não é usada na eficiência: o IC das médias usa a
+// variância no lugar do desvio padrão (gerar_intervalo_media), e o IC das variâncias
+// só depende do número de rodadas. Para V[W1] e V[W2], v vem da variância das
+// variâncias de cada rodada, cuja média é a estimativa do simulador.
+//
+// Uso: ./benchmark [num_rodadas] [repeticoes]
+//
+// num_rodadas é o número de rodadas do modo K fixo (padrão 4000). O modo K automático
+// começa com K/FATOR_K_AUTOMATICO (arredondado para baixo) e com o número de rodadas
+// arredondado para cima que simula pelo menos os mesmos num_rodadas*K clientes (no
+// máximo K/FATOR_K_AUTOMATICO a mais). O número de clientes simulados após a fase
+// transiente é impresso em cada linha. Cada combinação é repetida `repeticoes` vezes
+// (padrão 1) com sementes diferentes, e as precisões e tempos são médias das repetições.
+
+#define SEED 358141284 // Semente da primeira repetição
+#define FATOR_K_AUTOMATICO 8ul
+
+#define mu 1.0 // Taxa de serviço
+
+// Grade de rho com os K e K_t usados nos resultados do relatório
+#define NUM_RHOS 5
+const double rhos[NUM_RHOS] = {0.2, 0.4, 0.6, 0.8, 0.9};
+const unsigned long Ks[NUM_RHOS] = {40ul, 70ul, 150ul, 800ul, 7000ul};
+const unsigned long K_ts[NUM_RHOS] = {40ul, 120ul, 300ul, 900ul, 9000ul};
+
+#define NUM_GERADORES 2
+const Gerador geradores[NUM_GERADORES] = {GERADOR_XORSHIFT, GERADOR_LCG48};
+const char *nomes_geradores[NUM_GERADORES] = {"xorshift", "lcg48"};
+
+#define NUM_MODOS 2
+const char *nomes_modos[NUM_MODOS] = {"K fixo", "K auto"};
+
+#define NUM_METRICAS 10
+const char *nomes_metricas[NUM_METRICAS] = {
+    "E[W1]", "E[T1]", "E[Nq1]", "E[N1]", "E[W2]", "E[T2]", "E[Nq2]", "E[N2]", "V[W1]", "V[W2]"
+};
+
+/**
+ * Medições de uma combinação de rho e opções do simulador
+*/
+typedef struct Medicao
+{
+    int rho; // Índice em rhos
+    int gerador; // Índice em geradores
+    int modo; // Índice em nomes_modos
+    unsigned long coletas_rodada; // K usado nos ICs (da última repetição)
+    unsigned long num_rodadas; // Rodadas usadas nos ICs (da última repetição)
+    unsigned long num_clientes; // Clientes simulados após a fase transiente
+    double tempo; // Tempo de CPU médio de uma simulação, em segundos
+    double precisao[NUM_METRICAS]; // Precisão média de cada métrica
+    double variancia_relativa[NUM_METRICAS]; // Variância relativa média da estimativa de cada métrica
+} Medicao;
+
+/**
+ * Copia a precisão de cada métrica do `resultado` para `precisao`, na ordem de nomes_metricas
+*/
+void precisoes_resultado(const ResultadoSimulacao *resultado, double *precisao) {
+    precisao[0] = resultado->E_W1.precisao;
+    precisao[1] = resultado->E_T1.precisao;
+    precisao[2] = resultado->E_Nq1.precisao;
+    precisao[3] = resultado->E_N1.precisao;
+    precisao[4] = resultado->E_W2.precisao;
+    precisao[5] = resultado->E_T2.precisao;
+    precisao[6] = resultado->E_Nq2.precisao;
+    precisao[7] = resultado->E_N2.precisao;
+    precisao[8] = resultado->V_W1.precisao;
+    precisao[9] = resultado->V_W2.precisao;
+}
+
+/**
+ * Copia as métricas da `rodada` para `valores`, na ordem de nomes_metricas
+*/
+void valores_rodada(const MetricasRodada *rodada, double *valores) {
+    valores[0] = rodada->E_W1;
+    valores[1] = rodada->E_T1;
+    valores[2] = rodada->E_Nq1;
+    valores[3] = rodada->E_N1;
+    valores[4] = rodada->E_W2;
+    valores[5] = rodada->E_T2;
+    valores[6] = rodada->E_Nq2;
+    valores[7] = rodada->E_N2;
+    valores[8] = rodada->V_W1;
+    valores[9] = rodada->V_W2;
+}
+
+/**
+ * Preenche `variancia_relativa` com a variância relativa s^2/(n*media^2) da média
+ * das `num_rodadas` rodadas, para cada métrica
+*/
+void variancias_relativas(const MetricasRodada *rodadas, unsigned long num_rodadas, double *variancia_relativa) {
+    double media[NUM_METRICAS] = {0.0};
+    double valores[NUM_METRICAS];
+
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        valores_rodada(&rodadas[i], valores);
+        for (int m = 0; m < NUM_METRICAS; m++) {
+            media[m] += valores[m];
+        }
+    }
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        media[m] /= num_rodadas;
+        variancia_relativa[m] = 0.0;
+    }
+
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        valores_rodada(&rodadas[i], valores);
+        for (int m = 0; m < NUM_METRICAS; m++) {
+            variancia_relativa[m] += (valores[m] - media[m])*(valores[m] - media[m]);
+        }
+    }
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        variancia_relativa[m] /= (num_rodadas - 1)*num_rodadas*media[m]*media[m];
+    }
+}
+
+/**
+ * Executa as `repeticoes` simulações de uma combinação e preenche a `medicao`
+*/
+void medir(Medicao *medicao, unsigned long num_rodadas, unsigned long repeticoes) {
+    ParametrosSimulacao parametros = {
+        .taxa_chegada = rhos[medicao->rho]*mu/2.0,
+        .taxa_servico = mu,
+        .coletas_rodada = Ks[medicao->rho],
+        .coletas_transiente = K_ts[medicao->rho],
+        .num_rodadas = num_rodadas,
+        .gerador = geradores[medicao->gerador],
+        .k_automatico = medicao->modo
+    };
+    if (parametros.k_automatico) {
+        parametros.coletas_rodada = Ks[medicao->rho] / FATOR_K_AUTOMATICO;
+        if (parametros.coletas_rodada < 2ul) parametros.coletas_rodada = 2ul;
+        unsigned long clientes = num_rodadas * Ks[medicao->rho];
+        parametros.num_rodadas = (clientes + parametros.coletas_rodada - 1) / parametros.coletas_rodada;
+    }
+    medicao->num_clientes = parametros.num_rodadas * parametros.coletas_rodada;
+
+    medicao->tempo = 0.0;
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        medicao->precisao[m] = 0.0;
+        medicao->variancia_relativa[m] = 0.0;
+    }
+
+    MetricasRodada *rodadas = malloc(sizeof(MetricasRodada) * parametros.num_rodadas);
+    for (unsigned long r = 0ul; r < repeticoes; r++) {
+        ResultadoSimulacao resultado;
+        double precisao[NUM_METRICAS];
+        double variancia_relativa[NUM_METRICAS];
+        parametros.semente = SEED + r;
+
+        // Mesmo processamento de executar_simulacao(), mas guardando as médias das
+        // rodadas usadas nos ICs (já agrupadas no modo K automático)
+        clock_t inicio = clock();
+        Simulacao *sim = criar_simulacao(&parametros);
+        if (sim == NULL) {
+            fprintf(stderr, "Parâmetros inválidos para rho = %.1f\n", rhos[medicao->rho]);
+            exit(1);
+        }
+        while (!simulacao_encerrada(sim)) {
+            processar_prox_evento(sim, NULL);
+        }
+        unsigned long num_rodadas_IC = parametros.num_rodadas;
+        for (unsigned long i = 0ul; i < num_rodadas_IC; i++) {
+            metricas_rodada(sim, i + 1, &rodadas[i]);
+        }
+        destruir_simulacao(sim);
+        if (parametros.k_automatico) {
+            num_rodadas_IC = agrupar_rodadas(rodadas, num_rodadas_IC);
+        }
+        calcular_IC_metricas(rodadas, num_rodadas_IC, &resultado);
+        medicao->tempo += (double) (clock() - inicio) / CLOCKS_PER_SEC;
+
+        precisoes_resultado(&resultado, precisao);
+        variancias_relativas(rodadas, num_rodadas_IC, variancia_relativa);
+        for (int m = 0; m < NUM_METRICAS; m++) {
+            medicao->precisao[m] += precisao[m];
+            medicao->variancia_relativa[m] += variancia_relativa[m];
+        }
+        medicao->coletas_rodada = resultado.coletas_rodada;
+        medicao->num_rodadas = resultado.num_rodadas;
+    }
+    free(rodadas);
+
+    medicao->tempo /= repeticoes;
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        medicao->precisao[m] /= repeticoes;
+        medicao->variancia_relativa[m] /= repeticoes;
+    }
+}
+
+/**
+ * Imprime as colunas que identificam a combinação da `medicao`
+*/
+void imprimir_combinacao(const Medicao *medicao) {
+    printf("%-4.1f %-9s %-7s %7lu %8lu %9lu %8.3f",
+           rhos[medicao->rho], nomes_geradores[medicao->gerador], nomes_modos[medicao->modo],
+           medicao->coletas_rodada, medicao->num_rodadas, medicao->num_clientes, medicao->tempo);
+}
+
+/**
+ * Imprime o cabeçalho de uma tabela
+*/
+void imprimir_cabecalho(const char *titulo) {
+    printf("%s\n", titulo);
+    printf("%-4s %-9s %-7s %7s %8s %9s %8s", "rho", "gerador", "modo", "K", "rodadas", "clientes", "CPU (s)");
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        printf(" %9s", nomes_metricas[m]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char const *argv[])
+{
+    unsigned long num_rodadas = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4000ul;
+    unsigned long repeticoes = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1ul;
+    if (num_rodadas < 2ul || repeticoes < 1ul) {
+        fprintf(stderr, "Uso: %s [num_rodadas >= 2] [repeticoes >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    int num_medicoes = NUM_RHOS * NUM_GERADORES * NUM_MODOS;
+    Medicao *medicoes = malloc(sizeof(Medicao) * num_medicoes);
+
+    int i = 0;
+    for (int r = 0; r < NUM_RHOS; r++) {
+        for (int g = 0; g < NUM_GERADORES; g++) {
+            for (int modo = 0; modo < NUM_MODOS; modo++) {
+                medicoes[i] = (Medicao) {.rho = r, .gerador = g, .modo = modo};
+                medir(&medicoes[i], num_rodadas, repeticoes);
+                i++;
+            }
+        }
+    }
+
+    imprimir_cabecalho("Precisão relativa dos ICs do simulador (%, precisao_IC)");
+    for (i = 0; i < num_medicoes; i++) {
+        imprimir_combinacao(&medicoes[i]);
+        for (int m = 0; m < NUM_METRICAS; m++) {
+            printf(" %9.3f", medicoes[i].precisao[m]*100);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    imprimir_cabecalho("Variância relativa normalizada pelo trabalho (s^2/(n*media^2) * CPU s, menor é melhor)");
+    for (i = 0; i < num_medicoes; i++) {
+        imprimir_combinacao(&medicoes[i]);
+        for (int m = 0; m < NUM_METRICAS; m++) {
+            printf(" %9.2e", medicoes[i].variancia_relativa[m]*medicoes[i].tempo);
+        }
+        printf("\n");
+    }
+
+    free(medicoes);
+    return 0;
+}
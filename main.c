@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "simulador.h"
+
+/*----- Configurações do Simulador -----*/
+
+#define SEED 358141284 // Semente da geração de números aleatórios
+#define GERADOR GERADOR_XORSHIFT // Gerador de números aleatórios (GERADOR_XORSHIFT ou GERADOR_LCG48)
+
+#define mu 1.0 // Taxa de serviço
+#define rho 0.6 // Utilização do servidor
+
+#define K 150ul // Número de coletas por rodada
+#define K_t 300ul // Número de coletas da fase transiente
+#define NUM_RODADAS 4000ul // Número de rodadas
+#define K_AUTOMATICO 0 // Se != 0, K é escolhido automaticamente: rodadas adjacentes são
+                       // agrupadas (dobrando K) até que suas médias pareçam independentes.
+                       // Nesse caso K e NUM_RODADAS são o ponto de partida (K pequeno, muitas rodadas)
+#define PRINT_RESULTADO_RODADA 0 // Se imprime ou não o resultado de cada rodada
+                                 // (imprime se != 0)
+#define GRAVAR_TRACE 0 // Se grava ou não o trace binário dos eventos processados
+                       // (grava se != 0), usado pelo replay
+#define ARQUIVO_TRACE "simulador.trace" // Arquivo em que o trace é gravado
+
+#define DIVISAO 0 // Se != 0, em vez das rodadas, estima P(W2 > T_W2) por divisão de trajetórias
+                  // (RESTART) guiada pelo número de clientes na fila 2
+#define T_W2 40.0 // O t de P(W2 > t)
+#define LIMIAR_INICIAL 2ul // Número de clientes na fila 2 do primeiro limiar
+#define PASSO_LIMIAR 2ul // Distância entre limiares consecutivos
+#define NUM_LIMIARES 8ul // Número de limiares (0 é a simulação sem divisão)
+#define FATOR_DIVISAO 2ul // Número de cópias da trajetória em cada limiar
+#define NUM_CICLOS 1000000ul // Número de ciclos regenerativos (chegadas ao sistema vazio)
+
+// Cofigurações utilizadas nos resultados do relatório
+// rho          0.2     0.4     0.6     0.8     0.9
+// K            40ul    70ul    150ul   800ul   7000ul
+// K_t          40ul    120ul   300ul   900ul   9000ul
+// NUM_RODADAS  4000ul  4000ul  4000ul  4000ul  4000ul
+//
+// Configurações da divisão testadas (P(W2 > t) ~ 6e-4 e 8e-4)
+// rho              0.6     0.9
+// T_W2             40.0    200.0
+// LIMIAR_INICIAL   2ul     10ul
+// PASSO_LIMIAR     2ul     10ul
+// NUM_LIMIARES     8ul     8ul
+// FATOR_DIVISAO    2ul     2ul
+
+/*--------------------------------------*/
+
+// rho = 2*lambda*E[X] = 2*lambda/mu -> lambda = rho*mu/2
+#define lambda rho*mu/2.0
+
+// Trace dos eventos processados. Os registros são acumulados em buffer_trace
+// e gravados em blocos no arquivo_trace
+#define TAMANHO_BUFFER_TRACE 4096ul
+FILE *arquivo_trace;
+RegistroTrace buffer_trace[TAMANHO_BUFFER_TRACE];
+unsigned long registros_buffer_trace;
+unsigned long eventos_gravados_trace;
+
+/**
+ * Abre o arquivo de trace em `caminho` e grava o cabeçalho com os `parametros`
+ * da simulação. O número de eventos só é preenchido em fechar_trace()
+*/
+void abrir_trace(const char *caminho, const ParametrosSimulacao *parametros) {
+    arquivo_trace = fopen(caminho, "wb");
+    if (arquivo_trace == NULL) {
+        fprintf(stderr, "Não foi possível criar o trace %s\n", caminho);
+        exit(1);
+    }
+    registros_buffer_trace = 0ul;
+    eventos_gravados_trace = 0ul;
+
+    CabecalhoTrace cabecalho = {0};
+    memcpy(cabecalho.assinatura, ASSINATURA_TRACE, sizeof(cabecalho.assinatura));
+    cabecalho.versao = VERSAO_TRACE;
+    cabecalho.tamanho_registro = sizeof(RegistroTrace);
+    cabecalho.taxa_chegada = parametros->taxa_chegada;
+    cabecalho.taxa_servico = parametros->taxa_servico;
+    cabecalho.coletas_rodada = parametros->coletas_rodada;
+    cabecalho.coletas_transiente = parametros->coletas_transiente;
+    cabecalho.num_rodadas = parametros->num_rodadas;
+    cabecalho.semente = parametros->semente;
+    fwrite(&cabecalho, sizeof(CabecalhoTrace), 1, arquivo_trace);
+}
+
+/**
+ * Retorna o próximo registro livre do buffer do trace, gravando o buffer
+ * no arquivo antes se ele estiver cheio
+*/
+RegistroTrace *prox_registro_trace() {
+    if (registros_buffer_trace == TAMANHO_BUFFER_TRACE) {
+        fwrite(buffer_trace, sizeof(RegistroTrace), registros_buffer_trace, arquivo_trace);
+        eventos_gravados_trace += registros_buffer_trace;
+        registros_buffer_trace = 0ul;
+    }
+    return &buffer_trace[registros_buffer_trace++];
+}
+
+/**
+ * Grava os eventos restantes no buffer, preenche o número de eventos do
+ * cabeçalho e fecha o arquivo de trace
+*/
+void fechar_trace() {
+    fwrite(buffer_trace, sizeof(RegistroTrace), registros_buffer_trace, arquivo_trace);
+    eventos_gravados_trace += registros_buffer_trace;
+    registros_buffer_trace = 0ul;
+
+    uint64_t num_eventos = eventos_gravados_trace;
+    fseek(arquivo_trace, offsetof(CabecalhoTrace, num_eventos), SEEK_SET);
+    fwrite(&num_eventos, sizeof(uint64_t), 1, arquivo_trace);
+    fclose(arquivo_trace);
+}
+
+/**
+ * Imprime as métricas de uma rodada
+*/
+void imprimir_rodada(const MetricasRodada *rodada) {
+    printf("E[W1]: %f\n", rodada->E_W1);
+    printf("E[T1]: %f\n", rodada->E_T1);
+    printf("E[Nq1]: %f\n", rodada->E_Nq1);
+    printf("E[N1]: %f\n", rodada->E_N1);
+    printf("E[W2]: %f\n", rodada->E_W2);
+    printf("E[T2]: %f\n", rodada->E_T2);
+    printf("E[Nq2]: %f\n", rodada->E_Nq2);
+    printf("E[N2]: %f\n", rodada->E_N2);
+    printf("V[W1]: %f\n", rodada->V_W1);
+    printf("V[W2]: %f\n", rodada->V_W2);
+    printf("\n\n");
+}
+
+/**
+ * Imprime o IC de uma métrica no formato
+ * [Métrica coletada]: [Limite inferior] - [média do IC] - [Limite superior]
+*/
+void imprimir_intervalo(const char *nome, const IntervaloConfianca *IC) {
+    printf("%s: %f - %f - %f (p = %.2f%%)\n", nome, IC->inferior, IC->media, IC->superior, IC->precisao*100);
+}
+
+/**
+ * Imprime os ICs de todas as métricas
+*/
+void imprimir_resultado(const ResultadoSimulacao *resultado) {
+    imprimir_intervalo("E[W1]", &resultado->E_W1);
+    imprimir_intervalo("E[T1]", &resultado->E_T1);
+    imprimir_intervalo("E[Nq1]", &resultado->E_Nq1);
+    imprimir_intervalo("E[N1]", &resultado->E_N1);
+    imprimir_intervalo("E[W2]", &resultado->E_W2);
+    imprimir_intervalo("E[T2]", &resultado->E_T2);
+    imprimir_intervalo("E[Nq2]", &resultado->E_Nq2);
+    imprimir_intervalo("E[N2]", &resultado->E_N2);
+    imprimir_intervalo("V[W1]", &resultado->V_W1);
+    imprimir_intervalo("V[W2]", &resultado->V_W2);
+    printf("\n\n");
+}
+
+/**
+ * Estima P(W2 > T_W2) por divisão de trajetórias e imprime o resultado
+*/
+int executar_modo_divisao() {
+    ParametrosDivisao parametros = {
+        .taxa_chegada = lambda,
+        .taxa_servico = mu,
+        .limite_W2 = T_W2,
+        .limiar_inicial = LIMIAR_INICIAL,
+        .passo_limiar = PASSO_LIMIAR,
+        .num_limiares = NUM_LIMIARES,
+        .fator_divisao = FATOR_DIVISAO,
+        .num_ciclos = NUM_CICLOS,
+        .semente = SEED,
+        .gerador = GERADOR
+    };
+    ResultadoDivisao resultado;
+    if (executar_divisao(&parametros, &resultado) != 0) {
+        fprintf(stderr, "Configuração da divisão inválida\n");
+        return 1;
+    }
+
+    // Probabilidades raras, então os ICs são impressos em notação científica
+    const IntervaloConfianca *IC = &resultado.P_W2;
+    printf("P(W2 > %g): %e - %e - %e (p = %.2f%%)\n", T_W2, IC->inferior, IC->media, IC->superior, IC->precisao*100);
+    IC = &resultado.P_W2_principal;
+    printf("P(W2 > %g) sem divisão: %e - %e - %e (p = %.2f%%)\n", T_W2, IC->inferior, IC->media, IC->superior, IC->precisao*100);
+    printf("\n%lu ciclos, %lu clientes na trajetória principal, %lu cópias, %lu eventos\n",
+           resultado.num_ciclos, resultado.clientes_principal, resultado.num_copias, resultado.num_eventos);
+    if (resultado.P_W2.media == 0.0) {
+        printf("Aviso: nenhuma partida com W2 > %g, aumente NUM_LIMIARES ou NUM_CICLOS.\n", T_W2);
+    }
+    return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    // marca o incio da simulação
+    time_t inicio = time(NULL);
+
+    if (DIVISAO) {
+        int status = executar_modo_divisao();
+        printf("A simulação levou %ld segundos.\n", time(NULL)-inicio);
+        return status;
+    }
+
+    ParametrosSimulacao parametros = {
+        .taxa_chegada = lambda,
+        .taxa_servico = mu,
+        .coletas_rodada = K,
+        .coletas_transiente = K_t,
+        .num_rodadas = NUM_RODADAS,
+        .semente = SEED,
+        .gerador = GERADOR,
+        .k_automatico = K_AUTOMATICO
+    };
+    Simulacao *sim = criar_simulacao(&parametros);
+    if (sim == NULL) {
+        fprintf(stderr, "Configuração do simulador inválida\n");
+        return 1;
+    }
+    if (GRAVAR_TRACE) {
+        abrir_trace(ARQUIVO_TRACE, &parametros);
+    }
+
+    // Realiza a simulação propriamente dita, agenda e processa os eventos
+    // Se GRAVAR_TRACE != 0, cada evento processado é gravado no trace
+    while(!simulacao_encerrada(sim)) {
+        processar_prox_evento(sim, GRAVAR_TRACE ? prox_registro_trace() : NULL);
+    }
+
+    if (GRAVAR_TRACE) {
+        fechar_trace();
+    }
+
+    if (PRINT_RESULTADO_RODADA) {
+        MetricasRodada metricas;
+        for (unsigned long i = 1ul; i <= NUM_RODADAS; i++) {
+            metricas_rodada(sim, i, &metricas);
+            imprimir_rodada(&metricas);
+        }
+    }
+
+    // Imprime na tela os ICs coletados pela simulação.
+    // Os resultados são impressos no seguinte formato:
+    // [Métrica coletada]: [Limite inferior] - [média do IC] - [Limite superior]
+    ResultadoSimulacao resultado;
+    calcular_IC_rodadas(sim, &resultado);
+    imprimir_resultado(&resultado);
+    destruir_simulacao(sim);
+
+    if (K_AUTOMATICO) {
+        printf("K escolhido: %lu (%lu rodadas)\n", resultado.coletas_rodada, resultado.num_rodadas);
+    }
+    if (!resultado.rodadas_independentes) {
+        printf("Aviso: as médias das rodadas não passaram no teste de independência, aumente K.\n");
+    }
+
+    // marca o final da simulação
+    time_t fim = time(NULL);
+
+    // imprime o tempo da simulação na tela
+    printf("A simulação levou %ld segundos.\n", fim-inicio);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "simulador.h"
+
+// Recalcula as métricas da simulação a partir de um trace gravado pelo simulador
+// (GRAVAR_TRACE != 0), sem simular novamente. O K, o K_t e o número de rodadas
+// podem ser diferentes dos usados na simulação que gerou o trace.
+//
+// Uso: ./replay <trace> [K] [K_t] [num_rodadas]
+//
+// Parâmetros omitidos (ou iguais a 0) usam os valores gravados no cabeçalho do
+// trace, exceto num_rodadas=0 explícito, que usa todas as rodadas completas do trace.
+// Com os mesmos parâmetros da simulação, a saída é idêntica à do simulador.
+//
+// Os registros são aplicados por reproduzir_registro(), com os mesmos tratadores de
+// eventos do simulador. Métricas adicionais podem ser calculadas no laço de replay,
+// a partir de cada registro aplicado.
+
+/**
+ * Imprime o IC de uma métrica no mesmo formato do simulador
+*/
+void imprimir_intervalo(const char *nome, const IntervaloConfianca *IC) {
+    printf("%s: %f - %f - %f (p = %.2f%%)\n", nome, IC->inferior, IC->media, IC->superior, IC->precisao*100);
+}
+
+/**
+ * Calcula os ICs das `n` primeiras rodadas de `sim` após a fase transiente e
+ * imprime o resultado na tela, no mesmo formato do simulador
+*/
+void imprimir_IC_rodadas(const Simulacao *sim, unsigned long n) {
+    MetricasRodada *metricas = malloc(sizeof(MetricasRodada) * n);
+    for (unsigned long i = 0ul; i < n; i++) {
+        metricas_rodada(sim, i + 1, &metricas[i]);
+    }
+
+    ResultadoSimulacao resultado;
+    calcular_IC_metricas(metricas, n, &resultado);
+    free(metricas);
+
+    imprimir_intervalo("E[W1]", &resultado.E_W1);
+    imprimir_intervalo("E[T1]", &resultado.E_T1);
+    imprimir_intervalo("E[Nq1]", &resultado.E_Nq1);
+    imprimir_intervalo("E[N1]", &resultado.E_N1);
+    imprimir_intervalo("E[W2]", &resultado.E_W2);
+    imprimir_intervalo("E[T2]", &resultado.E_T2);
+    imprimir_intervalo("E[Nq2]", &resultado.E_Nq2);
+    imprimir_intervalo("E[N2]", &resultado.E_N2);
+    imprimir_intervalo("V[W1]", &resultado.V_W1);
+    imprimir_intervalo("V[W2]", &resultado.V_W2);
+    printf("\n\n");
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <trace> [K] [K_t] [num_rodadas]\n", argv[0]);
+        return 1;
+    }
+
+    // Mapeia o trace em memória, ele é lido sequencialmente uma única vez
+    int fd = open(argv[1], O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(CabecalhoTrace)) {
+        fprintf(stderr, "Não foi possível ler o trace %s\n", argv[1]);
+        return 1;
+    }
+    const unsigned char *mapa = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapa == MAP_FAILED) {
+        fprintf(stderr, "Não foi possível mapear o trace %s\n", argv[1]);
+        return 1;
+    }
+    madvise((void *) mapa, info.st_size, MADV_SEQUENTIAL);
+
+    // O número de eventos é comparado sem multiplicar, pois um cabeçalho malformado
+    // poderia estourar num_eventos*sizeof(RegistroTrace) e passar na verificação
+    const CabecalhoTrace *cabecalho = (const CabecalhoTrace *) mapa;
+    if (memcmp(cabecalho->assinatura, ASSINATURA_TRACE, sizeof(cabecalho->assinatura)) != 0 ||
+        cabecalho->versao != VERSAO_TRACE ||
+        cabecalho->tamanho_registro != sizeof(RegistroTrace) ||
+        cabecalho->num_eventos > ((uint64_t) info.st_size - sizeof(CabecalhoTrace)) / sizeof(RegistroTrace)) {
+        fprintf(stderr, "%s não é um trace válido\n", argv[1]);
+        return 1;
+    }
+    const RegistroTrace *registros = (const RegistroTrace *) (mapa + sizeof(CabecalhoTrace));
+
+    unsigned long K = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0ul;
+    unsigned long K_t = (argc > 3) ? strtoul(argv[3], NULL, 10) : 0ul;
+    unsigned long num_rodadas = (argc > 4) ? strtoul(argv[4], NULL, 10) : cabecalho->num_rodadas;
+    if (K == 0ul) K = cabecalho->coletas_rodada;
+    if (K_t == 0ul) K_t = cabecalho->coletas_transiente;
+
+    // Com num_rodadas = 0 o replay vai até o fim do trace, e o número de rodadas
+    // dos parâmetros não é usado
+    ParametrosSimulacao parametros = {
+        .taxa_chegada = cabecalho->taxa_chegada,
+        .taxa_servico = cabecalho->taxa_servico,
+        .coletas_rodada = K,
+        .coletas_transiente = K_t,
+        .num_rodadas = (num_rodadas > 0ul) ? num_rodadas : cabecalho->num_rodadas,
+        .semente = cabecalho->semente
+    };
+    Simulacao *sim = criar_reproducao(&parametros);
+    if (sim == NULL) {
+        fprintf(stderr, "Configuração do replay inválida (K >= 2, K_t >= 1 e num_rodadas >= 2)\n");
+        return 1;
+    }
+
+    // Reproduz os eventos até encerrar num_rodadas rodadas (ou até o fim do trace se num_rodadas = 0)
+    uint64_t i;
+    for (i = 0; i < cabecalho->num_eventos; i++) {
+        if (num_rodadas > 0ul && simulacao_encerrada(sim)) break;
+        if (reproduzir_registro(sim, &registros[i]) != 0) {
+            fprintf(stderr, "Trace inconsistente no evento %lu (momento %f, cliente %lu, tipo %u): "
+                    "momento anterior ao do evento anterior, tipo sem evento pendente ou cliente inesperado\n",
+                    (unsigned long) i, registros[i].momento, (unsigned long) registros[i].id_cliente, registros[i].tipo);
+            return 1;
+        }
+    }
+
+    unsigned long rodadas_completas = num_rodadas_encerradas(sim);
+    if (rodadas_completas < 2ul) {
+        fprintf(stderr, "O trace não tem rodadas completas suficientes com K=%lu e K_t=%lu\n", K, K_t);
+        return 1;
+    }
+    if (num_rodadas == 0ul || rodadas_completas < num_rodadas) {
+        if (num_rodadas > 0ul) {
+            fprintf(stderr, "O trace só tem %lu rodadas completas\n", rodadas_completas);
+        }
+        num_rodadas = rodadas_completas;
+    }
+
+    printf("Replay de %lu eventos: K=%lu, K_t=%lu, %lu rodadas\n", (unsigned long) i, K, K_t, num_rodadas);
+    imprimir_IC_rodadas(sim, num_rodadas);
+
+    destruir_simulacao(sim);
+    munmap((void *) mapa, info.st_size);
+    close(fd);
+
+    return 0;
+}
@@ -1,42 +1,18 @@
-#include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
-#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "simulador.h"
 
-/*----- Configurações do Simulador -----*/
-
-#define SEED 358141284 // Semente da geração de números aleatórios
-
-#define mu 1.0 // Taxa de serviço
-#define rho 0.6 // Utilização do servidor
-
-#define K 150ul // Número de coletas por rodada
-#define K_t 300ul // Número de coletas da fase transiente
-#define NUM_RODADAS 4000ul // Número de rodadas
-#define p_variancia 0.044 // Precisão da variância para o número de rodadas fornecido
-#define PRINT_RESULTADO_RODADA 0 // Se imprime ou não o resultado de cada rodada
-                                 // (imprime se != 0)
-
-// Cofigurações utilizadas nos resultados do relatório
-// rho          0.2     0.4     0.6     0.8     0.9
-// K            40ul    70ul    150ul   800ul   7000ul
-// K_t          40ul    120ul   300ul   900ul   9000ul
-// NUM_RODADAS  4000ul  4000ul  4000ul  4000ul  4000ul
-
-/*--------------------------------------*/
-
-// rho = 2*lambda*E[X] = 2*lambda/mu -> lambda = rho*mu/2 
-#define lambda rho*mu/2.0
-
 /**
  * Estrutura que contém as métricas coletadas de cada rodada
 */
-struct Rodada
+typedef struct Rodada
 {
     double inicio; // momento em que a rodada começou
-    Rodada *prox_rodada; // Ponteiro para a proxima rodada
+    unsigned long indice; // Posição da rodada em Simulacao.rodadas (a fase transiente é a 0)
 
     double E_W1; // E[W1]
     double E_T1; // E[T1]
@@ -49,8 +25,15 @@ struct Rodada
     double V_W1; // V[W1]
     double V_W2; // V[W2]
 
-    double W1[K]; // W1 de cada cliente, usado para calcular V(W1)
-    double W2[K]; // W2 de cada cliente, usado para calcular V(W2)
+    // Acumuladores do algoritmo de Welford para V(W1) e V(W2): média parcial e
+    // somatório dos quadrados dos desvios em relação a ela (não usados na fase transiente)
+    double media_W1;
+    double M2_W1;
+    double media_W2;
+    double M2_W2;
+    unsigned long num_servicos_1; // Número de clientes da rodada que já entraram no serviço 1
+
+    double duracao; // Duração da rodada, preenchida ao encerrar a coleta
 
     // Variáveis auxiliares no cáculo do número de pessoas na fila.
     // Armazenam o último instante em que cada número de pessoas na fila foi atualizado
@@ -61,69 +44,117 @@ struct Rodada
 
     unsigned long num_chegadas; // Número de clientes que chegaram na rodada
     unsigned long num_partidas; // Número de clientes que chegaram na rodada e já partiram
-};
+} Rodada;
 
 /**
- * Estrutura que representa um cliente no sistema
+ * Estrutura que representa um cliente no sistema. Os clientes ficam armazenados
+ * por valor nas filas de espera, então a estrutura é mantida compacta
 */
-struct Cliente
+typedef struct Cliente
 {
-    Rodada *rodada; // Rodada na qual o cliente chegou
-    Cliente *prox_cliente; // Ponteiro para o cliente atrás dele na fila em que ele está
-
-    unsigned long indice_rodada; // O i-ésimo cliente que chegar na rodada tem indice_rodada=i
     double chegada_estado_atual; // Instante de tempo em que o cliente chegou no estado atual (espera 1, serviço 1, espera 2 ou serviço 2)
     double chegada_fila_atual; // Instante de tempo em que o cliente chegou na fila atual (fila1 ou fila2)
-};
+    double W2; // Tempo que o cliente já esperou na fila 2, somando as interrupções
+    uint32_t rodada; // Índice em Simulacao.rodadas da rodada na qual o cliente chegou
+    uint32_t indice_rodada; // O i-ésimo cliente que chegar na rodada tem indice_rodada=i
+} Cliente;
 
 /**
- * Estrutura que representa uma fila de clientes
+ * Estrutura que representa uma fila de clientes, um buffer circular que dobra
+ * de tamanho quando fica cheio
 */
-struct FilaEspera
+typedef struct FilaEspera
 {
-    Cliente *primeiro_cliente; // Primeiro cliente na fila
-    Cliente *ultimo_cliente; // Último cliente da fila
+    Cliente *clientes; // Buffer com os clientes da fila
+    unsigned long capacidade; // Tamanho do buffer, sempre uma potência de 2
+    unsigned long inicio; // Posição do primeiro cliente no buffer
     unsigned long num_clientes; // Número de clientes na fila
-};
-
-// Tipos de eventos agendáveis
-enum tipo_evento {chegada_fila_1 = 0, chegada_fila_2, partida};
+} FilaEspera;
 
 // Um evento agendável (nem todos os eventos são agendáveis)
+// O cliente ao qual o evento se refere é implícito no tipo: uma chegada na fila 1
+// é de um novo cliente, uma chegada na fila 2 é do primeiro cliente da fila 1 e
+// uma partida é do primeiro cliente da fila 2
+typedef struct Evento Evento;
 struct Evento {
     Evento *prox_evento; // Ponteiro para o próximo evento a ser tratado
     double momento; // Momento em que o evento deve ser tratado
-    Cliente *cliente; // Cliente ao qual o evento se refere
     TipoEvento tipo; // Tipo do evento
 };
 
-// Evento sendo tratado atualmente, também representa a fila de eventos
-// A fila de eventos é uma lista encadeada, que começa pelo evento_atual
-Evento *evento_atual;
+/**
+ * Estado de um gerador de números aleatórios
+*/
+typedef struct EstadoGerador
+{
+    Gerador tipo; // Gerador usado
+    uint64_t estado; // Estado atual do gerador
+} EstadoGerador;
+
+/**
+ * Contexto de uma simulação, guarda todo o seu estado
+*/
+struct Simulacao
+{
+    ParametrosSimulacao parametros; // Parâmetros com os quais a simulação foi criada
+
+    EstadoGerador gerador; // Gerador de números aleatórios
+
+    // Se != 0, a simulação reproduz um trace (criar_reproducao): os momentos dos
+    // eventos vêm dos registros e nenhuma amostra é gerada
+    int reproducao;
+
+    // Momento do último evento processado
+    double momento_atual;
+
+    // Evento sendo tratado atualmente, também representa a fila de eventos
+    // A fila de eventos é uma lista encadeada, que começa pelo evento_atual
+    Evento *evento_atual;
+
+    // Filas de espera, o cliente não deixa essas filas ao entrar em serviço, apenas
+    // quando entra na outra fila ou quando parte do sistema
+    FilaEspera *fila1;
+    FilaEspera *fila2;
 
-// Filas de espera, o cliente não deixa essas filas ao entrar em serviço, apenas
-// quando entra na outra fila ou quando parte do sistema
-FilaEspera *fila1;
-FilaEspera *fila2;
+    // Rodadas realizadas, em ordem. A posição 0 é a fase transiente
+    // e a última é a rodada_atual
+    Rodada **rodadas;
+    unsigned long num_rodadas_criadas;
+    unsigned long capacidade_rodadas;
+    Rodada *fase_transiente;
+    Rodada *rodada_atual;
 
-// Ponteiros das rodadas. As rodadas realizadas ficam em uma fila encadeada,
-// que começa pela fase_transiente e termina na rodada_atual;
-Rodada *fase_transiente;
-Rodada *rodada_atual;
+    // Numero de rodadas já encerradas
+    unsigned long rodadas_encerradas;
 
-// Numero de rodadas já encerradas
-unsigned long rodadas_encerradas;
+    // Numero de clientes que já chegaram no sistema
+    unsigned long clientes_criados;
+};
+
+static void processar_chegada_fila_1(Simulacao *sim);
+static void processar_chegada_fila_2(Simulacao *sim);
+static void processar_partida(Simulacao *sim);
+static void processar_chegada_servico_1(Simulacao *sim);
+static void processar_chegada_servico_2(Simulacao *sim);
+static void interromper_servico_fila_2(Simulacao *sim);
+static void encerrar_coleta(Simulacao *sim, Rodada *rodada);
 
 /**
- * Cria uma nova rodada e retorna um ponteiro
+ * Cria uma nova rodada, adiciona ela ao final das rodadas da simulação e retorna um ponteiro
 */
-Rodada *criar_rodada() {
+static Rodada *criar_rodada(Simulacao *sim) {
     Rodada *nova_rodada = malloc(sizeof(Rodada));
 
-    double momento_atual = (evento_atual == NULL)? 0.0 : evento_atual->momento;
-    
+    double momento_atual = (sim->evento_atual == NULL)? 0.0 : sim->evento_atual->momento;
+
+    if (sim->num_rodadas_criadas == sim->capacidade_rodadas) {
+        sim->capacidade_rodadas *= 2;
+        sim->rodadas = realloc(sim->rodadas, sizeof(Rodada *) * sim->capacidade_rodadas);
+    }
+    nova_rodada->indice = sim->num_rodadas_criadas;
+    sim->rodadas[sim->num_rodadas_criadas++] = nova_rodada;
+
     nova_rodada->inicio = momento_atual;
-    nova_rodada->prox_rodada = NULL;
     nova_rodada->E_W1 = 0.0;
     nova_rodada->E_W2 = 0.0;
     nova_rodada->E_T1 = 0.0;
@@ -132,11 +163,20 @@ Rodada *criar_rodada() {
     nova_rodada->E_Nq2 = 0.0;
     nova_rodada->E_N1 = 0.0;
     nova_rodada->E_N2 = 0.0;
+    nova_rodada->V_W1 = 0.0;
+    nova_rodada->V_W2 = 0.0;
     nova_rodada->ultima_atualizacao_E_Nq1 = momento_atual;
     nova_rodada->ultima_atualizacao_E_N1 = momento_atual;
     nova_rodada->ultima_atualizacao_E_Nq2 = momento_atual;
     nova_rodada->ultima_atualizacao_E_N2 = momento_atual;
 
+    nova_rodada->media_W1 = 0.0;
+    nova_rodada->M2_W1 = 0.0;
+    nova_rodada->media_W2 = 0.0;
+    nova_rodada->M2_W2 = 0.0;
+    nova_rodada->num_servicos_1 = 0ul;
+    nova_rodada->duracao = 0.0;
+
     nova_rodada->num_chegadas = 0l;
     nova_rodada->num_partidas = 0l;
 
@@ -146,85 +186,110 @@ Rodada *criar_rodada() {
 /**
  * Inicia a fase transiente
 */
-void iniciar_fase_transiente() {
-    fase_transiente = criar_rodada();
-    rodada_atual = fase_transiente;
+static void iniciar_fase_transiente(Simulacao *sim) {
+    sim->fase_transiente = criar_rodada(sim);
+    sim->rodada_atual = sim->fase_transiente;
 }
 
 /**
  * Inicia uma nova rodada (que não é a fase transiente)
 */
-void iniciar_nova_rodada() {
-    rodada_atual->prox_rodada = criar_rodada();
-    rodada_atual = rodada_atual->prox_rodada;
+static void iniciar_nova_rodada(Simulacao *sim) {
+    sim->rodada_atual = criar_rodada(sim);
 }
 
 /**
- * Cria um novo cliente pertencente à `rodada` e retorna um ponteiro
+ * Retorna o número de coletas da `rodada`
 */
-Cliente *criar_cliente(Rodada *rodada) {
-    Cliente *novo_cliente = malloc(sizeof(Cliente));
-    novo_cliente->rodada = rodada;
-    novo_cliente->prox_cliente = NULL;
-    novo_cliente->chegada_estado_atual = 0.0;
-    novo_cliente->chegada_fila_atual = 0.0;
-    novo_cliente->indice_rodada = rodada->num_chegadas;
+static unsigned long coletas_rodada(const Simulacao *sim, const Rodada *rodada) {
+    if (rodada == sim->fase_transiente) {
+        return sim->parametros.coletas_transiente;
+    }
+    return sim->parametros.coletas_rodada;
+}
 
-    return novo_cliente;
+/**
+ * Retorna o id do `cliente`, isto é, sua ordem de chegada no sistema
+*/
+static unsigned long id_cliente(const Simulacao *sim, const Cliente *cliente) {
+    if (cliente->rodada == 0u) {
+        return cliente->indice_rodada;
+    }
+    return sim->parametros.coletas_transiente
+        + (cliente->rodada - 1ul) * sim->parametros.coletas_rodada
+        + cliente->indice_rodada;
 }
 
 /**
  * Cria uma nova fila e retorna um ponteiro
 */
-FilaEspera *criar_fila() {
+static FilaEspera *criar_fila() {
     FilaEspera *nova_fila = malloc(sizeof(FilaEspera));
+    nova_fila->capacidade = 16ul;
+    nova_fila->clientes = malloc(sizeof(Cliente) * nova_fila->capacidade);
+    nova_fila->inicio = 0ul;
     nova_fila->num_clientes = 0l;
-    nova_fila->primeiro_cliente = NULL;
-    nova_fila->ultimo_cliente = NULL;
 
     return nova_fila;
 }
 
 /**
- * Adiciona o `cliente`no final da `fila`
+ * Adiciona uma cópia do `cliente` no final da `fila`
 */
-void adicionar_cliente_fila(FilaEspera *fila, Cliente *cliente) {
-    if (fila->num_clientes == 0) {
-        fila->primeiro_cliente = cliente;
-    } else {
-        fila->ultimo_cliente->prox_cliente = cliente;
+static void adicionar_cliente_fila(FilaEspera *fila, const Cliente *cliente) {
+    // Se o buffer está cheio, dobra o seu tamanho e desfaz a volta do buffer circular
+    if (fila->num_clientes == fila->capacidade) {
+        Cliente *clientes = malloc(sizeof(Cliente) * fila->capacidade * 2);
+        unsigned long num_ate_fim = fila->capacidade - fila->inicio;
+        memcpy(clientes, &fila->clientes[fila->inicio], sizeof(Cliente) * num_ate_fim);
+        memcpy(&clientes[num_ate_fim], fila->clientes, sizeof(Cliente) * fila->inicio);
+        free(fila->clientes);
+
+        fila->clientes = clientes;
+        fila->inicio = 0ul;
+        fila->capacidade *= 2;
     }
 
-    fila->ultimo_cliente = cliente;
+    fila->clientes[(fila->inicio + fila->num_clientes) & (fila->capacidade - 1)] = *cliente;
     fila->num_clientes += 1;
 }
 
 /**
- * Retorna um ponteiro para o proximo cliente da `fila` e remove ele da `fila`
+ * Retorna um ponteiro para o primeiro cliente da `fila`, que continua nela
 */
-Cliente *prox_cliente_fila(FilaEspera *fila) {
-    Cliente *primeiro_cliente = fila->primeiro_cliente;
-    fila->primeiro_cliente = primeiro_cliente->prox_cliente;
+static Cliente *primeiro_cliente_fila(FilaEspera *fila) {
+    return &fila->clientes[fila->inicio];
+}
 
+/**
+ * Retorna o proximo cliente da `fila` e remove ele da `fila`
+*/
+static Cliente prox_cliente_fila(FilaEspera *fila) {
+    Cliente primeiro_cliente = fila->clientes[fila->inicio];
+    fila->inicio = (fila->inicio + 1) & (fila->capacidade - 1);
     fila->num_clientes -= 1;
-    if(fila->num_clientes == 0) {
-        fila->ultimo_cliente = NULL;
-    }
 
     return primeiro_cliente;
 }
 
+/**
+ * Libera a `fila`
+*/
+static void destruir_fila(FilaEspera *fila) {
+    free(fila->clientes);
+    free(fila);
+}
+
 /**
  * Cria um novo evento, onde `momento` é o instante em que ele foi agendado
- * `cliente` é o cliente que ele afeta, e `tipo` é o tipo do evento.
+ * e `tipo` é o tipo do evento.
  * Retorna um ponteiro para o evento criado
 */
-Evento *criar_evento(double momento,Cliente *cliente, TipoEvento tipo) {
+static Evento *criar_evento(double momento, TipoEvento tipo) {
     Evento *novo_evento = malloc(sizeof(Evento));
 
     novo_evento->prox_evento = NULL;
     novo_evento->momento = momento;
-    novo_evento->cliente = cliente;
     novo_evento->tipo = tipo;
 
     return novo_evento;
@@ -232,10 +297,10 @@ Evento *criar_evento(double momento,Cliente *cliente, TipoEvento tipo) {
 
 /**
  * Cria um novo evento, onde `momento` é o instante em que ele foi agendado
- * `cliente` é o cliente que ele afeta, e `tipo` é o tipo do evento, e agenda
- * esse evento na fila de eventos
+ * e `tipo` é o tipo do evento, e agenda esse evento na fila de eventos que
+ * começa pelo `evento_atual`
 */
-void agendar_evento(double momento, Cliente *cliente, TipoEvento tipo) {
+static void agendar_evento(Evento *evento_atual, double momento, TipoEvento tipo) {
 
     // Evento que antecede o evento a ser agendado
     Evento *evento_aterior = evento_atual;
@@ -246,36 +311,93 @@ void agendar_evento(double momento, Cliente *cliente, TipoEvento tipo) {
     }
 
     // Atualiza a fila para encaixar o evento agendado
-    Evento *novo_evento = criar_evento(momento, cliente, tipo);
+    Evento *novo_evento = criar_evento(momento, tipo);
     novo_evento->prox_evento = evento_aterior->prox_evento;
     evento_aterior->prox_evento = novo_evento;
 }
 
+/**
+ * Remove da fila de eventos que começa pelo `evento_atual` o evento de partida,
+ * se houver algum agendado. Retorna se um evento foi removido
+*/
+static int cancelar_partida(Evento *evento_atual) {
+    for(Evento *e = evento_atual; e->prox_evento != NULL; e = e->prox_evento) {
+        if (e->prox_evento->tipo == partida) {
+
+            Evento *partida = e->prox_evento;
+            e->prox_evento = partida->prox_evento;
+
+            free(partida);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Inicializa o `gerador` do `tipo` fornecido a partir da `semente` com um passo do
+ * splitmix64, o que evita o estado nulo (inválido no xorshift). O LCG48 usa só os
+ * 48 bits menos significativos
+*/
+static void iniciar_gerador(EstadoGerador *gerador, Gerador tipo, uint64_t semente) {
+    uint64_t z = semente + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    gerador->tipo = tipo;
+    gerador->estado = (z ^ (z >> 31)) | 1ull;
+}
+
+/**
+ * Retorna uma amostra de U(0,1], gerada pelo `gerador`
+*/
+static double amostra_uniforme(EstadoGerador *gerador) {
+    if (gerador->tipo == GERADOR_LCG48) {
+        // X[n+1] = (a*X[n] + c) mod 2^48
+        gerador->estado = (gerador->estado * 0x5DEECE66Dull + 0xBull) & 0xFFFFFFFFFFFFull;
+        return (gerador->estado + 1) * (1.0 / 281474976710656.0); // (1..2^48) / 2^48
+    }
+
+    // xorshift64*
+    gerador->estado ^= gerador->estado >> 12;
+    gerador->estado ^= gerador->estado << 25;
+    gerador->estado ^= gerador->estado >> 27;
+    uint64_t x = gerador->estado * 0x2545F4914F6CDD1Dull;
+    return ((x >> 11) + 1) * (1.0 / 9007199254740992.0); // (1..2^53) / 2^53
+}
+
 /**
  * Retorna uma amostra exponencial com a `taxa` fornecida
 */
-double amostra_exponencial(double taxa) {
-    double u_0 = (double) rand()/RAND_MAX; // amostra de U(0,1)
+static double amostra_exponencial(EstadoGerador *gerador, double taxa) {
+    double u_0 = amostra_uniforme(gerador); // amostra de U(0,1)
     return -(log(u_0)/taxa);
 }
 
 /**
- * Retorna a variância dos valores no array X, onde E_X é a média de X, isto é, E[X]
+ * Retorna a duração até um evento com a `taxa` fornecida. Na reprodução de um trace
+ * o momento do evento vem do registro, então ele é agendado para o infinito
 */
-double variancia(double E_X, double *X) {
-    double somatorio = 0.0;
-    for (unsigned long i = 0ul; i < K; i++) {
-        somatorio += (X[i]- E_X)*(X[i]- E_X);
-    }
-    return somatorio/(K-1);
+static double amostra_duracao(Simulacao *sim, double taxa) {
+    if (sim->reproducao) return INFINITY;
+    return amostra_exponencial(&sim->gerador, taxa);
+}
+
+/**
+ * Acumula a `n`-ésima amostra `x` na `media` parcial e no somatório `M2` dos
+ * quadrados dos desvios (algoritmo de Welford). A variância das n amostras é M2/(n-1)
+*/
+static void acumular_amostra(double x, unsigned long n, double *media, double *M2) {
+    double desvio = x - *media;
+    *media += desvio/n;
+    *M2 += desvio*(x - *media);
 }
 
 /**
  * Retorna número de pessoas na fila de espera 1 atualmente
 */
-long get_Nq1() {
-    if (fila1->num_clientes > 0l) {
-        return fila1->num_clientes-1;
+static long get_Nq1(const Simulacao *sim) {
+    if (sim->fila1->num_clientes > 0l) {
+        return sim->fila1->num_clientes-1;
     }
     return 0l;
 }
@@ -283,18 +405,18 @@ long get_Nq1() {
 /**
  * Retorna número de pessoas na fila 1 atualmente (incluindo o que está em serviço)
 */
-long get_N1() {
-    return fila1->num_clientes;
+static long get_N1(const Simulacao *sim) {
+    return sim->fila1->num_clientes;
 }
 
 /**
  * Retorna número de pessoas na fila de espera 2 atualmente
 */
-long get_Nq2() {
-    if (fila1->num_clientes > 0l) {
-        return fila2->num_clientes;
-    } else if(fila2->num_clientes > 0l) {
-        return fila2->num_clientes-1;
+static long get_Nq2(const Simulacao *sim) {
+    if (sim->fila1->num_clientes > 0l) {
+        return sim->fila2->num_clientes;
+    } else if(sim->fila2->num_clientes > 0l) {
+        return sim->fila2->num_clientes-1;
     }
     return 0l;
 }
@@ -302,58 +424,62 @@ long get_Nq2() {
 /**
  * Retorna número de pessoas na fila 2 atualmente (incluindo o que está em serviço)
 */
-long get_N2() {
-    return fila2->num_clientes;
+static long get_N2(const Simulacao *sim) {
+    return sim->fila2->num_clientes;
 }
 
 /**
  * Atualiza o valor de E[Nq1] na rodada atual
 */
-void atualizar_E_Nq1() {
-    rodada_atual->E_Nq1 += get_Nq1() * (evento_atual->momento - rodada_atual->ultima_atualizacao_E_Nq1);
-    rodada_atual->ultima_atualizacao_E_Nq1 = evento_atual->momento;
+static void atualizar_E_Nq1(Simulacao *sim) {
+    Rodada *rodada_atual = sim->rodada_atual;
+    rodada_atual->E_Nq1 += get_Nq1(sim) * (sim->evento_atual->momento - rodada_atual->ultima_atualizacao_E_Nq1);
+    rodada_atual->ultima_atualizacao_E_Nq1 = sim->evento_atual->momento;
 }
 
 /**
  * Atualiza o valor de E[N1] na rodada atual
 */
-void atualizar_E_N1() {
-    rodada_atual->E_N1 += get_N1() * (evento_atual->momento - rodada_atual->ultima_atualizacao_E_N1);
-    rodada_atual->ultima_atualizacao_E_N1 = evento_atual->momento;
+static void atualizar_E_N1(Simulacao *sim) {
+    Rodada *rodada_atual = sim->rodada_atual;
+    rodada_atual->E_N1 += get_N1(sim) * (sim->evento_atual->momento - rodada_atual->ultima_atualizacao_E_N1);
+    rodada_atual->ultima_atualizacao_E_N1 = sim->evento_atual->momento;
 }
 
 /**
  * Atualiza o valor de E[Nq2] na rodada atual
 */
-void atualizar_E_Nq2() {
-    rodada_atual->E_Nq2 += get_Nq2() * (evento_atual->momento - rodada_atual->ultima_atualizacao_E_Nq2);
-    rodada_atual->ultima_atualizacao_E_Nq2 = evento_atual->momento;
+static void atualizar_E_Nq2(Simulacao *sim) {
+    Rodada *rodada_atual = sim->rodada_atual;
+    rodada_atual->E_Nq2 += get_Nq2(sim) * (sim->evento_atual->momento - rodada_atual->ultima_atualizacao_E_Nq2);
+    rodada_atual->ultima_atualizacao_E_Nq2 = sim->evento_atual->momento;
 }
 
 /**
  * Atualiza o valor de E[N2] na rodada atual
 */
-void atualizar_E_N2() {
-    rodada_atual->E_N2 += get_N2() * (evento_atual->momento - rodada_atual->ultima_atualizacao_E_N2);
-    rodada_atual->ultima_atualizacao_E_N2 = evento_atual->momento;
+static void atualizar_E_N2(Simulacao *sim) {
+    Rodada *rodada_atual = sim->rodada_atual;
+    rodada_atual->E_N2 += get_N2(sim) * (sim->evento_atual->momento - rodada_atual->ultima_atualizacao_E_N2);
+    rodada_atual->ultima_atualizacao_E_N2 = sim->evento_atual->momento;
 }
 
 /**
  * Realiza o tratamento do evento atual
 */
-void processar_evento_atual() {
-    switch (evento_atual->tipo)
+static void processar_evento_atual(Simulacao *sim) {
+    switch (sim->evento_atual->tipo)
     {
     case chegada_fila_1:
-        processar_chegada_fila_1(); 
+        processar_chegada_fila_1(sim);
         break;
     case chegada_fila_2:
-        processar_chegada_fila_2();
+        processar_chegada_fila_2(sim);
         break;
     case partida:
-        processar_partida();
+        processar_partida(sim);
         break;
-    
+
     default:
         break;
     }
@@ -362,97 +488,109 @@ void processar_evento_atual() {
 /**
  * Realiza o tratamento de uma chegada na fila 1
 */
-void processar_chegada_fila_1() {
+static void processar_chegada_fila_1(Simulacao *sim) {
+    Evento *evento_atual = sim->evento_atual;
 
-    // Atualiza E[Nq1], E[N1], E[N2], E[Nq2] da rodada atual
-    atualizar_E_N1();
-    if (get_N1() > 0l) {
-        atualizar_E_Nq1();
-    }
-    if (get_N2() > 0l) {
-        atualizar_E_Nq2();
-    }
+    // Atualiza E[Nq1], E[N1], E[N2], E[Nq2] da rodada atual. As quatro são atualizadas
+    // mesmo quando a chegada não as altera, pois ela pode iniciar uma nova rodada, e
+    // a área acumulada até aqui pertence à rodada que está terminando
+    atualizar_E_N1(sim);
+    atualizar_E_Nq1(sim);
+    atualizar_E_N2(sim);
+    atualizar_E_Nq2(sim);
 
     // Atualiza variáveis auxiliares
-    adicionar_cliente_fila(fila1, evento_atual->cliente);
-    evento_atual->cliente->chegada_estado_atual = evento_atual->momento;
-    evento_atual->cliente->chegada_fila_atual = evento_atual->momento;
-    rodada_atual->num_chegadas += 1;
+    Cliente novo_cliente;
+    novo_cliente.chegada_estado_atual = evento_atual->momento;
+    novo_cliente.chegada_fila_atual = evento_atual->momento;
+    novo_cliente.W2 = 0.0;
+    novo_cliente.rodada = (uint32_t) sim->rodada_atual->indice;
+    novo_cliente.indice_rodada = (uint32_t) sim->rodada_atual->num_chegadas;
+    adicionar_cliente_fila(sim->fila1, &novo_cliente);
+    sim->rodada_atual->num_chegadas += 1;
+    sim->clientes_criados += 1;
 
     // Se o numero de coletas da rodada atual foi atingido, inicia uma nova rodada
-    if (rodada_atual != fase_transiente && rodada_atual->num_chegadas == K ||
-        rodada_atual == fase_transiente && rodada_atual->num_chegadas == K_t) {
-            iniciar_nova_rodada();
-        }
+    if (sim->rodada_atual->num_chegadas == coletas_rodada(sim, sim->rodada_atual)) {
+        iniciar_nova_rodada(sim);
+    }
 
     // Se não há outros clientes da fila 1 no sistema, o que chegou agora entra em serviço imediatamte
-    if(fila1->num_clientes == 1l) {
-        processar_chegada_servico_1();
+    if(sim->fila1->num_clientes == 1l) {
+        processar_chegada_servico_1(sim);
     }
 
     //Agenda a próxima chegada à fila 1
-    double prox_chegada_fila_1 = evento_atual->momento + amostra_exponencial(lambda);
-    agendar_evento(prox_chegada_fila_1, criar_cliente(rodada_atual), chegada_fila_1);
+    double prox_chegada_fila_1 = evento_atual->momento + amostra_duracao(sim, sim->parametros.taxa_chegada);
+    agendar_evento(sim->evento_atual, prox_chegada_fila_1, chegada_fila_1);
 }
 
 
 /**
  * Realiza o tratamento de uma chegada na fila 2
 */
-void processar_chegada_fila_2() {
+static void processar_chegada_fila_2(Simulacao *sim) {
+    double momento = sim->evento_atual->momento;
+    Cliente *cliente = primeiro_cliente_fila(sim->fila1);
 
     // Atualiza E[T1] da rodada do cliente
-    evento_atual->cliente->rodada->E_T1 += evento_atual->momento - evento_atual->cliente->chegada_fila_atual;
-    evento_atual->cliente->chegada_fila_atual = evento_atual->momento;
-    evento_atual->cliente->chegada_estado_atual = evento_atual->momento;
+    sim->rodadas[cliente->rodada]->E_T1 += momento - cliente->chegada_fila_atual;
+    cliente->chegada_fila_atual = momento;
+    cliente->chegada_estado_atual = momento;
 
     // Atualiza E[Nq1], E[Nq2], E[N1] e E[N2] da rodada atual
-    atualizar_E_N1();
-    atualizar_E_N2();
-    atualizar_E_Nq2();
-    if (get_Nq1() > 0l) {
-        atualizar_E_Nq1();
+    atualizar_E_N1(sim);
+    atualizar_E_N2(sim);
+    atualizar_E_Nq2(sim);
+    if (get_Nq1(sim) > 0l) {
+        atualizar_E_Nq1(sim);
     }
 
-    adicionar_cliente_fila(fila2, prox_cliente_fila(fila1));
+    Cliente cliente_servido = prox_cliente_fila(sim->fila1);
+    adicionar_cliente_fila(sim->fila2, &cliente_servido);
 
     // Se houverem clientes na fila 1, um cliente dessa fila entra em serviço,
     // caso contrário, um cliente da fila 2 entra em serviço
-    if (fila1->num_clientes > 0l) {
-        processar_chegada_servico_1();
+    if (sim->fila1->num_clientes > 0l) {
+        processar_chegada_servico_1(sim);
     } else {
-        processar_chegada_servico_2();
+        processar_chegada_servico_2(sim);
     }
 }
 
 /**
  * Realiza o tratamento de uma partida do sistema
 */
-void processar_partida() {
+static void processar_partida(Simulacao *sim) {
+    Cliente *cliente = primeiro_cliente_fila(sim->fila2);
+    Rodada *rodada_cliente = sim->rodadas[cliente->rodada];
 
     // Atualiza E[T2] da rodada do cliente
-    evento_atual->cliente->rodada->E_T2 += evento_atual->momento - evento_atual->cliente->chegada_fila_atual;
+    rodada_cliente->E_T2 += sim->evento_atual->momento - cliente->chegada_fila_atual;
+
+    // Acumula o W2 do cliente para V(W2)
+    rodada_cliente->num_partidas += 1;
+    if (rodada_cliente != sim->fase_transiente)
+        acumular_amostra(cliente->W2, rodada_cliente->num_partidas, &rodada_cliente->media_W2, &rodada_cliente->M2_W2);
 
     // Se todos os clientes da rodada já partiram, encerra a coleta
-    evento_atual->cliente->rodada->num_partidas += 1;
-    if (evento_atual->cliente->rodada != fase_transiente && evento_atual->cliente->rodada->num_partidas == K ||
-        evento_atual->cliente->rodada == fase_transiente && evento_atual->cliente->rodada->num_partidas == K_t) {
-            encerrar_coleta(evento_atual->cliente->rodada);
-            rodadas_encerradas += 1ul;
-        }
+    if (rodada_cliente->num_partidas == coletas_rodada(sim, rodada_cliente)) {
+        encerrar_coleta(sim, rodada_cliente);
+        sim->rodadas_encerradas += 1ul;
+    }
 
     // Atualiza E[N2] e E[Nq2] da rodada atual
-    atualizar_E_N2();
-    if (get_Nq2() > 0l) {
-        atualizar_E_Nq2();
+    atualizar_E_N2(sim);
+    if (get_Nq2(sim) > 0l) {
+        atualizar_E_Nq2(sim);
     }
 
-    free(prox_cliente_fila(fila2));
+    prox_cliente_fila(sim->fila2);
 
     // Se tiver outro cliente na fila 2, ele entra em serviço
     // Nunca terá um cliente na fila 1 pois caso contrário a partida teria sido interrompida
-    if(fila2->num_clientes > 0l) {
-        processar_chegada_servico_2();
+    if(sim->fila2->num_clientes > 0l) {
+        processar_chegada_servico_2(sim);
     }
 }
 
@@ -461,77 +599,75 @@ void processar_partida() {
  * Realiza o tratamento de uma chegada no serviço 1
  * Equivalente à uma partida da fila 1
 */
-void processar_chegada_servico_1() {
-
-    // Atualiza E[W1] e o array W1 da rodada do cliente
-    fila1->primeiro_cliente->rodada->E_W1 += evento_atual->momento - fila1->primeiro_cliente->chegada_estado_atual;
-    if (fila1->primeiro_cliente->rodada != fase_transiente)
-        fila1->primeiro_cliente->rodada->W1[fila1->primeiro_cliente->indice_rodada] 
-            = evento_atual->momento - fila1->primeiro_cliente->chegada_estado_atual;
-    fila1->primeiro_cliente->chegada_estado_atual = evento_atual->momento;
+static void processar_chegada_servico_1(Simulacao *sim) {
+    double momento = sim->evento_atual->momento;
+    Cliente *cliente = primeiro_cliente_fila(sim->fila1);
+    Rodada *rodada_cliente = sim->rodadas[cliente->rodada];
+
+    // Atualiza E[W1] e os acumuladores de V(W1) da rodada do cliente
+    rodada_cliente->E_W1 += momento - cliente->chegada_estado_atual;
+    if (rodada_cliente != sim->fase_transiente) {
+        rodada_cliente->num_servicos_1 += 1;
+        acumular_amostra(momento - cliente->chegada_estado_atual, rodada_cliente->num_servicos_1,
+                         &rodada_cliente->media_W1, &rodada_cliente->M2_W1);
+    }
+    cliente->chegada_estado_atual = momento;
 
     // interrompe o cliente da fila 2 em serviço (se houver algum)
-    interromper_servico_fila_2();
+    interromper_servico_fila_2(sim);
 
     // Agenda o término do serviço que está começando
-    double termino_servico = evento_atual->momento + amostra_exponencial(mu);
-    agendar_evento(termino_servico, fila1->primeiro_cliente, chegada_fila_2);
+    double termino_servico = momento + amostra_duracao(sim, sim->parametros.taxa_servico);
+    agendar_evento(sim->evento_atual, termino_servico, chegada_fila_2);
 }
 
 /**
  * Realiza o tratamento de uma chegada no serviço 2
  * Equivalente à uma partida da fila 2
 */
-void processar_chegada_servico_2() {
+static void processar_chegada_servico_2(Simulacao *sim) {
+    double momento = sim->evento_atual->momento;
+    Cliente *cliente = primeiro_cliente_fila(sim->fila2);
+    Rodada *rodada_cliente = sim->rodadas[cliente->rodada];
 
-    // Atualiza E[W2] e o array W2 da rodada do cliente
-    fila2->primeiro_cliente->rodada->E_W2 += evento_atual->momento - fila2->primeiro_cliente->chegada_estado_atual;
-    if(fila2->primeiro_cliente->rodada != fase_transiente)
-        fila2->primeiro_cliente->rodada->W2[fila2->primeiro_cliente->indice_rodada] 
-            += evento_atual->momento - fila2->primeiro_cliente->chegada_estado_atual;
-    fila2->primeiro_cliente->chegada_estado_atual = evento_atual->momento;
+    // Atualiza E[W2] da rodada e o W2 do cliente
+    rodada_cliente->E_W2 += momento - cliente->chegada_estado_atual;
+    cliente->W2 += momento - cliente->chegada_estado_atual;
+    cliente->chegada_estado_atual = momento;
 
     // Agenda o término do serviço que está começando
-    double termino_servico = evento_atual->momento + amostra_exponencial(mu);
-    agendar_evento(termino_servico, fila2->primeiro_cliente, partida);
+    double termino_servico = momento + amostra_duracao(sim, sim->parametros.taxa_servico);
+    agendar_evento(sim->evento_atual, termino_servico, partida);
 }
 
 
 /**
  * Realiza o tratamento de uma interrupção no serviço 2
 */
-void interromper_servico_fila_2() {
+static void interromper_servico_fila_2(Simulacao *sim) {
 
     // Se a fila 2 está vazia, não há quem interromper
-    if (fila2->num_clientes == 0) return;
+    if (sim->fila2->num_clientes == 0) return;
 
     // Cancela o evento de partida do sistema, se este estiver agendado
-    for(Evento *e = evento_atual; e->prox_evento != NULL; e = e->prox_evento) {
-        if (e->prox_evento->tipo == partida) {
-
-            Evento *partida = e->prox_evento;
-            e->prox_evento = partida->prox_evento;
-
-            partida->cliente->chegada_estado_atual = evento_atual->momento;
-
-            free(partida);
-            return;
-        }
+    // O cliente interrompido é o primeiro da fila 2
+    if (cancelar_partida(sim->evento_atual)) {
+        primeiro_cliente_fila(sim->fila2)->chegada_estado_atual = sim->evento_atual->momento;
     }
 }
 
 /**
  * Encerra a coleta da rodada
 */
-void encerrar_coleta(Rodada *rodada) {
+static void encerrar_coleta(Simulacao *sim, Rodada *rodada) {
     unsigned long num_coletas = rodada->num_chegadas;
-    double duracao_rodada = rodada->prox_rodada->inicio - rodada->inicio;
+    double duracao_rodada = sim->rodadas[rodada->indice + 1]->inicio - rodada->inicio;
 
     // Atualiza pela última vez o número de pessoas nas filas
-    atualizar_E_Nq1();
-    atualizar_E_Nq2();
-    atualizar_E_N1();
-    atualizar_E_N2();
+    atualizar_E_Nq1(sim);
+    atualizar_E_Nq2(sim);
+    atualizar_E_N1(sim);
+    atualizar_E_N2(sim);
 
     // Normaliza as métricas coletadas (que antes eram apenas somátórios das coletas)
     rodada->E_W1 /= num_coletas;
@@ -544,22 +680,205 @@ void encerrar_coleta(Rodada *rodada) {
     rodada->E_N2 /= duracao_rodada;
 
     // Calcula as variâncias
-    rodada->V_W1 = variancia(rodada->E_W1, &rodada->W1[0]);
-    rodada->V_W2 = variancia(rodada->E_W2, &rodada->W2[0]);
-    if (PRINT_RESULTADO_RODADA) {
-        printf("E[W1]: %f\n", rodada->E_W1);
-        printf("E[T1]: %f\n", rodada->E_T1);
-        printf("E[Nq1]: %f\n", rodada->E_Nq1);
-        printf("E[N1]: %f\n", rodada->E_N1);
-        printf("E[W2]: %f\n", rodada->E_W2);
-        printf("E[T2]: %f\n", rodada->E_T2);
-        printf("E[Nq2]: %f\n", rodada->E_Nq2);
-        printf("E[N2]: %f\n", rodada->E_N2);
-        printf("V[W1]: %f\n", rodada->V_W1);
-        printf("V[W2]: %f\n", rodada->V_W2);
-        printf("\n\n");
+    rodada->V_W1 = rodada->M2_W1/(num_coletas-1);
+    rodada->V_W2 = rodada->M2_W2/(num_coletas-1);
+    rodada->duracao = duracao_rodada;
+}
+
+/**
+ * Cria um contexto com os `parametros` fornecidos. Se `reproducao` != 0, os eventos
+ * vêm de um trace em vez do gerador. Retorna NULL se os parâmetros forem inválidos
+*/
+static Simulacao *iniciar_simulacao(const ParametrosSimulacao *parametros, int reproducao) {
+    if (parametros->taxa_chegada <= 0.0 || parametros->taxa_servico <= 0.0 ||
+        (parametros->gerador != GERADOR_XORSHIFT && parametros->gerador != GERADOR_LCG48) ||
+        parametros->coletas_rodada < 2ul || parametros->coletas_transiente < 1ul ||
+        parametros->num_rodadas < 2ul) {
+        return NULL;
+    }
+
+    Simulacao *sim = malloc(sizeof(Simulacao));
+    sim->parametros = *parametros;
+    sim->reproducao = reproducao;
+    sim->momento_atual = 0.0;
+
+    iniciar_gerador(&sim->gerador, parametros->gerador, (uint64_t) parametros->semente);
+
+    // Inicia o estado da simulação
+    sim->evento_atual = NULL;
+    sim->fila1 = criar_fila();
+    sim->fila2 = criar_fila();
+    sim->capacidade_rodadas = 64ul;
+    sim->num_rodadas_criadas = 0ul;
+    sim->rodadas = malloc(sizeof(Rodada *) * sim->capacidade_rodadas);
+    sim->rodadas_encerradas = 0ul;
+    sim->clientes_criados = 0ul;
+    iniciar_fase_transiente(sim);
+
+    // Agenda a primeira chegada
+    double primeira_chegada = amostra_duracao(sim, parametros->taxa_chegada);
+    sim->evento_atual = criar_evento(primeira_chegada, chegada_fila_1);
+
+    return sim;
+}
+
+/**
+ * Cria uma simulação com os `parametros` fornecidos, pronta para ter seus eventos
+ * processados. Retorna NULL se os parâmetros forem inválidos
+*/
+Simulacao *criar_simulacao(const ParametrosSimulacao *parametros) {
+    return iniciar_simulacao(parametros, 0);
+}
+
+/**
+ * Cria um contexto que reproduz um trace com os `parametros` fornecidos: os eventos
+ * não são gerados, e sim aplicados um a um por reproduzir_registro(). A semente e o
+ * gerador são ignorados. Retorna NULL se os parâmetros forem inválidos
+*/
+Simulacao *criar_reproducao(const ParametrosSimulacao *parametros) {
+    return iniciar_simulacao(parametros, 1);
+}
+
+/**
+ * Libera a simulação `sim` e tudo que foi alocado por ela
+*/
+void destruir_simulacao(Simulacao *sim) {
+    while (sim->evento_atual != NULL) {
+        Evento *temp = sim->evento_atual;
+        sim->evento_atual = temp->prox_evento;
+        free(temp);
+    }
+    destruir_fila(sim->fila1);
+    destruir_fila(sim->fila2);
+
+    for (unsigned long i = 0ul; i < sim->num_rodadas_criadas; i++) {
+        free(sim->rodadas[i]);
+    }
+    free(sim->rodadas);
+    free(sim);
+}
+
+/**
+ * Retorna se a simulação já encerrou a fase transiente e todas as rodadas
+*/
+int simulacao_encerrada(const Simulacao *sim) {
+    return sim->rodadas_encerradas >= sim->parametros.num_rodadas + 1;
+}
+
+/**
+ * Retorna o id do cliente ao qual um evento do `tipo` fornecido se refere
+ * no estado atual da simulação
+*/
+static unsigned long id_cliente_evento(Simulacao *sim, TipoEvento tipo) {
+    switch (tipo)
+    {
+    case chegada_fila_1:
+        return sim->clientes_criados;
+    case chegada_fila_2:
+        return id_cliente(sim, primeiro_cliente_fila(sim->fila1));
+    default:
+        return id_cliente(sim, primeiro_cliente_fila(sim->fila2));
+    }
+}
+
+/**
+ * Retorna o número de rodadas encerradas, sem contar a fase transiente
+*/
+unsigned long num_rodadas_encerradas(const Simulacao *sim) {
+    return (sim->rodadas_encerradas > 0ul) ? sim->rodadas_encerradas - 1 : 0ul;
+}
+
+/**
+ * Processa o próximo evento da simulação e o remove da fila de eventos.
+ * Se `registro` não for NULL, ele é preenchido com o evento processado
+*/
+void processar_prox_evento(Simulacao *sim, RegistroTrace *registro) {
+    if (registro != NULL) {
+        registro->momento = sim->evento_atual->momento;
+        registro->id_cliente = id_cliente_evento(sim, sim->evento_atual->tipo);
+        registro->tipo = (uint32_t) sim->evento_atual->tipo;
+        registro->reservado = 0u;
+    }
+
+    processar_evento_atual(sim);
+    sim->momento_atual = sim->evento_atual->momento;
+
+    Evento *temp = sim->evento_atual;
+    sim->evento_atual = sim->evento_atual->prox_evento;
+    free(temp);
+}
+
+/**
+ * Aplica o `registro` de um trace à simulação `sim`, criada por criar_reproducao(),
+ * com os mesmos tratadores de eventos da simulação. O evento pendente do tipo do
+ * registro passa a ser o evento atual, no momento do registro, e é processado.
+ * Retorna 0 em caso de sucesso e -1 se o registro for inconsistente com o estado da
+ * simulação: o momento é anterior ao do último evento processado (ou não é um número),
+ * não há evento pendente desse tipo ou o cliente não é o esperado
+*/
+int reproduzir_registro(Simulacao *sim, const RegistroTrace *registro) {
+    if (!sim->reproducao) return -1;
+
+    // Um evento no passado somaria áreas e tempos negativos às métricas
+    if (!(registro->momento >= sim->momento_atual)) return -1;
+
+    // Há no máximo um evento pendente de cada tipo
+    Evento **anterior = &sim->evento_atual;
+    while (*anterior != NULL && (uint32_t) (*anterior)->tipo != registro->tipo) {
+        anterior = &(*anterior)->prox_evento;
+    }
+    if (*anterior == NULL || id_cliente_evento(sim, (*anterior)->tipo) != registro->id_cliente) {
+        return -1;
+    }
+
+    // Retira o evento da fila de eventos e o coloca no início
+    Evento *evento = *anterior;
+    *anterior = evento->prox_evento;
+    evento->momento = registro->momento;
+    evento->prox_evento = sim->evento_atual;
+    sim->evento_atual = evento;
+
+    processar_prox_evento(sim, NULL);
+    return 0;
+}
+
+/**
+ * Preenche `metricas` com as métricas da rodada de índice `indice`, entre 1 e
+ * o número de rodadas. A rodada deve ter sido encerrada
+*/
+void metricas_rodada(const Simulacao *sim, unsigned long indice, MetricasRodada *metricas) {
+    const Rodada *rodada = sim->rodadas[indice];
+
+    metricas->E_W1 = rodada->E_W1;
+    metricas->E_T1 = rodada->E_T1;
+    metricas->E_Nq1 = rodada->E_Nq1;
+    metricas->E_N1 = rodada->E_N1;
+    metricas->E_W2 = rodada->E_W2;
+    metricas->E_T2 = rodada->E_T2;
+    metricas->E_Nq2 = rodada->E_Nq2;
+    metricas->E_N2 = rodada->E_N2;
+    metricas->V_W1 = rodada->V_W1;
+    metricas->V_W2 = rodada->V_W2;
+    metricas->num_coletas = rodada->num_chegadas;
+    metricas->duracao = rodada->duracao;
+}
+
+/**
+ * Executa uma simulação completa com os `parametros` fornecidos e preenche o
+ * `resultado` com os ICs. Retorna 0 em caso de sucesso e -1 se os parâmetros forem inválidos
+*/
+int executar_simulacao(const ParametrosSimulacao *parametros, ResultadoSimulacao *resultado) {
+    Simulacao *sim = criar_simulacao(parametros);
+    if (sim == NULL) return -1;
+
+    // Realiza a simulação propriamente dita, agenda e processa os eventos
+    while (!simulacao_encerrada(sim)) {
+        processar_prox_evento(sim, NULL);
     }
+    calcular_IC_rodadas(sim, resultado);
 
+    destruir_simulacao(sim);
+    return 0;
 }
 
 #define Z 1.959963 //Número da tabela Z
@@ -572,7 +891,7 @@ void encerrar_coleta(Rodada *rodada) {
  * `intervalo_confianca` é o array de duas posições que guarda
  * o limite inferior e superior do intervalo de confianca. A posição 0
  * é o limite inferior, e a posição 1 é o limite superior.
- * 
+ *
  * A função nao retorna nada diretamente, apenas altera os valores dentro do próprio
  * ponteiro passado como argumento em `intervalo_confianca`
 */
@@ -594,7 +913,7 @@ void gerar_intervalo_media(double media, double variancia, int n, double *interv
  * `intervalo_confianca` é o array de duas posições que guarda
  * o limite inferior e superior do intervalo de confianca. A posição 0
  * é o limite inferior, e a posição 1 é o limite superior.
- * 
+ *
  * A função nao retorna nada diretamente, apenas altera os valores dentro do próprio
  * ponteiro passado como argumento em `intervalo_confianca`
 */
@@ -611,9 +930,133 @@ double precisao_IC(double *intervalo_confianca) {
 }
 
 /**
- * Calcula os ICs da simulação e imprime o resultado na tela
+ * Retorna a precisão do IC da variância para o número de rodadas fornecido.
+ * Aproxima a qui-quadrado com n-1 graus de liberdade por uma normal,
+ * p = Z*sqrt(2/(n-1)) (p ~ 4.4% para 4000 rodadas)
+*/
+double precisao_intervalo_variancia(unsigned long num_rodadas) {
+    return Z * sqrt(2.0/(num_rodadas - 1));
+}
+
+/**
+ * Preenche o `intervalo` a partir da `media` e do array `IC` com os limites
+*/
+static void preencher_intervalo(IntervaloConfianca *intervalo, double media, double *IC) {
+    intervalo->inferior = IC[0];
+    intervalo->media = media;
+    intervalo->superior = IC[1];
+    intervalo->precisao = precisao_IC(IC);
+}
+
+/**
+ * Preenche `juncao` com as métricas da rodada formada pelas rodadas adjacentes `a` e `b`.
+ * As médias por cliente são ponderadas pelo número de coletas, as médias no tempo
+ * pela duração, e as variâncias são combinadas pela fórmula de Chan
+*/
+void juntar_rodadas(const MetricasRodada *a, const MetricasRodada *b, MetricasRodada *juncao) {
+    double n_a = a->num_coletas;
+    double n_b = b->num_coletas;
+    double n = n_a + n_b;
+    double d = a->duracao + b->duracao;
+
+    // Somatórios dos quadrados dos desvios de cada rodada em relação à sua média
+    double M2_W1 = a->V_W1*(n_a-1) + b->V_W1*(n_b-1) + (b->E_W1 - a->E_W1)*(b->E_W1 - a->E_W1)*n_a*n_b/n;
+    double M2_W2 = a->V_W2*(n_a-1) + b->V_W2*(n_b-1) + (b->E_W2 - a->E_W2)*(b->E_W2 - a->E_W2)*n_a*n_b/n;
+
+    juncao->E_W1 = (a->E_W1*n_a + b->E_W1*n_b)/n;
+    juncao->E_T1 = (a->E_T1*n_a + b->E_T1*n_b)/n;
+    juncao->E_W2 = (a->E_W2*n_a + b->E_W2*n_b)/n;
+    juncao->E_T2 = (a->E_T2*n_a + b->E_T2*n_b)/n;
+    juncao->E_Nq1 = (a->E_Nq1*a->duracao + b->E_Nq1*b->duracao)/d;
+    juncao->E_N1 = (a->E_N1*a->duracao + b->E_N1*b->duracao)/d;
+    juncao->E_Nq2 = (a->E_Nq2*a->duracao + b->E_Nq2*b->duracao)/d;
+    juncao->E_N2 = (a->E_N2*a->duracao + b->E_N2*b->duracao)/d;
+    juncao->V_W1 = M2_W1/(n-1);
+    juncao->V_W2 = M2_W2/(n-1);
+    juncao->num_coletas = a->num_coletas + b->num_coletas;
+    juncao->duracao = d;
+}
+
+// Posição das médias testadas pelo teste de independência dentro de MetricasRodada
+static const size_t medias_testadas[] = {
+    offsetof(MetricasRodada, E_W1), offsetof(MetricasRodada, E_T1),
+    offsetof(MetricasRodada, E_Nq1), offsetof(MetricasRodada, E_N1),
+    offsetof(MetricasRodada, E_W2), offsetof(MetricasRodada, E_T2),
+    offsetof(MetricasRodada, E_Nq2), offsetof(MetricasRodada, E_N2)
+};
+#define NUM_MEDIAS_TESTADAS (sizeof(medias_testadas)/sizeof(medias_testadas[0]))
+
+/**
+ * Retorna a métrica na posição `posicao` (um offsetof) da `rodada`
+*/
+static double valor_metrica(const MetricasRodada *rodada, size_t posicao) {
+    return *(const double *) ((const char *) rodada + posicao);
+}
+
+/**
+ * Retorna se as médias das `num_rodadas` rodadas podem ser consideradas independentes.
+ * Para cada métrica, aplica o teste de von Neumann à autocorrelação lag-1 das médias:
+ * C = 1 - somatorio (X[i+1]-X[i])^2 / (2*somatorio (X[i]-E[X])^2)
+ * que, sem correlação, é aproximadamente normal com média 0 e variância
+ * (n-2)/((n-1)(n+1)). As rodadas falham se C for maior que Z desvios padrão
+ * para alguma métrica (correlação positiva)
+*/
+int rodadas_independentes(const MetricasRodada *rodadas, unsigned long num_rodadas) {
+    double n = num_rodadas;
+    double desvio_padrao_C = sqrt((n-2)/((n-1)*(n+1)));
+
+    for (size_t m = 0; m < NUM_MEDIAS_TESTADAS; m++) {
+        double media = 0.0;
+        for (unsigned long i = 0ul; i < num_rodadas; i++) {
+            media += valor_metrica(&rodadas[i], medias_testadas[m]);
+        }
+        media /= n;
+
+        double somatorio_desvios = 0.0;
+        double somatorio_diferencas = 0.0;
+        for (unsigned long i = 0ul; i < num_rodadas; i++) {
+            double x = valor_metrica(&rodadas[i], medias_testadas[m]);
+            somatorio_desvios += (x - media)*(x - media);
+            if (i + 1 < num_rodadas) {
+                double diferenca = valor_metrica(&rodadas[i + 1], medias_testadas[m]) - x;
+                somatorio_diferencas += diferenca*diferenca;
+            }
+        }
+
+        // Métrica constante, não há correlação para testar
+        if (somatorio_desvios == 0.0) continue;
+
+        double C = 1.0 - somatorio_diferencas/(2.0*somatorio_desvios);
+        if (C > Z*desvio_padrao_C) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#define MIN_RODADAS_AGRUPADAS 32ul // Menor número de rodadas que agrupar_rodadas pode deixar
+
+/**
+ * Junta pares de rodadas adjacentes, dobrando o número de coletas por rodada, até
+ * que as médias das rodadas passem em rodadas_independentes() ou até que restem
+ * menos de 2*MIN_RODADAS_AGRUPADAS rodadas. Se o número de rodadas for ímpar, a
+ * última é descartada. As rodadas agrupadas ficam no início do array `rodadas`.
+ * Retorna o número de rodadas após os agrupamentos
 */
-void calcular_IC_rodadas() {
+unsigned long agrupar_rodadas(MetricasRodada *rodadas, unsigned long num_rodadas) {
+    while (!rodadas_independentes(rodadas, num_rodadas) && num_rodadas >= 2*MIN_RODADAS_AGRUPADAS) {
+        for (unsigned long i = 0ul; i < num_rodadas/2; i++) {
+            juntar_rodadas(&rodadas[2*i], &rodadas[2*i + 1], &rodadas[i]);
+        }
+        num_rodadas /= 2;
+    }
+    return num_rodadas;
+}
+
+/**
+ * Calcula os ICs das métricas das `num_rodadas` rodadas fornecidas e preenche o `resultado`
+*/
+void calcular_IC_metricas(const MetricasRodada *rodadas, unsigned long num_rodadas, ResultadoSimulacao *resultado) {
 
     // Calcula a média das métrica coletadas
 
@@ -628,9 +1071,8 @@ void calcular_IC_rodadas() {
     double media_V_W1 = 0.0;
     double media_V_W2 = 0.0;
 
-    Rodada * rodada = fase_transiente;
-    for (unsigned long i = 0ul; i < NUM_RODADAS; i++) {
-        rodada = rodada->prox_rodada;
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        const MetricasRodada *rodada = &rodadas[i];
 
         media_E_W1 += rodada->E_W1;
         media_E_T1 += rodada->E_T1;
@@ -643,16 +1085,16 @@ void calcular_IC_rodadas() {
         media_V_W1 += rodada->V_W1;
         media_V_W2 += rodada->V_W2;
     }
-    media_E_W1 /= NUM_RODADAS;
-    media_E_T1 /= NUM_RODADAS;
-    media_E_Nq1 /= NUM_RODADAS;
-    media_E_N1 /= NUM_RODADAS;
-    media_E_W2 /= NUM_RODADAS;
-    media_E_T2 /= NUM_RODADAS;
-    media_E_Nq2 /= NUM_RODADAS;
-    media_E_N2 /= NUM_RODADAS;
-    media_V_W1 /= NUM_RODADAS;
-    media_V_W2 /= NUM_RODADAS;
+    media_E_W1 /= num_rodadas;
+    media_E_T1 /= num_rodadas;
+    media_E_Nq1 /= num_rodadas;
+    media_E_N1 /= num_rodadas;
+    media_E_W2 /= num_rodadas;
+    media_E_T2 /= num_rodadas;
+    media_E_Nq2 /= num_rodadas;
+    media_E_N2 /= num_rodadas;
+    media_V_W1 /= num_rodadas;
+    media_V_W2 /= num_rodadas;
 
     // Cacula a variância das médias coletadas
 
@@ -664,9 +1106,8 @@ void calcular_IC_rodadas() {
     double var_E_T2 = 0.0;
     double var_E_Nq2 = 0.0;
     double var_E_N2 = 0.0;
-    rodada = fase_transiente;
-    for (unsigned long i = 0ul; i < NUM_RODADAS; i++) {
-        rodada = rodada->prox_rodada;
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        const MetricasRodada *rodada = &rodadas[i];
 
         var_E_W1 += (rodada->E_W1 - media_E_W1)*(rodada->E_W1 - media_E_W1);
         var_E_T1 += (rodada->E_T1 - media_E_T1)*(rodada->E_T1 - media_E_T1);
@@ -678,74 +1119,424 @@ void calcular_IC_rodadas() {
         var_E_N2 += (rodada->E_N2 - media_E_N2)*(rodada->E_N2 - media_E_N2);
     }
 
-    var_E_W1 /= (NUM_RODADAS-1);
-    var_E_T1 /= (NUM_RODADAS-1);
-    var_E_Nq1 /= (NUM_RODADAS-1);
-    var_E_N1 /= (NUM_RODADAS-1);
-    var_E_W2 /= (NUM_RODADAS-1);
-    var_E_T2 /= (NUM_RODADAS-1);
-    var_E_Nq2 /= (NUM_RODADAS-1);
-    var_E_N2 /= (NUM_RODADAS-1);
-
-    // Gera os ICs e imprime na tela
-    double *IC = malloc(sizeof(double)*2);
-    gerar_intervalo_media(media_E_W1, var_E_W1, NUM_RODADAS, IC);
-    printf("E[W1]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_W1, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_T1, var_E_T1, NUM_RODADAS, IC);
-    printf("E[T1]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_T1, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_Nq1, var_E_Nq1, NUM_RODADAS, IC);
-    printf("E[Nq1]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_Nq1, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_N1, var_E_N1, NUM_RODADAS, IC);
-    printf("E[N1]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_N1, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_W2, var_E_W2, NUM_RODADAS, IC);
-    printf("E[W2]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_W2, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_T2, var_E_T2, NUM_RODADAS, IC);
-    printf("E[T2]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_T2, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_Nq2, var_E_Nq2, NUM_RODADAS, IC);
-    printf("E[Nq2]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_Nq2, IC[1], precisao_IC(IC)*100);
-    gerar_intervalo_media(media_E_N2, var_E_N2, NUM_RODADAS, IC);
-    printf("E[N2]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_E_N2, IC[1], precisao_IC(IC)*100);
+    var_E_W1 /= (num_rodadas-1);
+    var_E_T1 /= (num_rodadas-1);
+    var_E_Nq1 /= (num_rodadas-1);
+    var_E_N1 /= (num_rodadas-1);
+    var_E_W2 /= (num_rodadas-1);
+    var_E_T2 /= (num_rodadas-1);
+    var_E_Nq2 /= (num_rodadas-1);
+    var_E_N2 /= (num_rodadas-1);
+
+    // Gera os ICs
+    double p_variancia = precisao_intervalo_variancia(num_rodadas);
+    double IC[2];
+    gerar_intervalo_media(media_E_W1, var_E_W1, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_W1, media_E_W1, IC);
+    gerar_intervalo_media(media_E_T1, var_E_T1, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_T1, media_E_T1, IC);
+    gerar_intervalo_media(media_E_Nq1, var_E_Nq1, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_Nq1, media_E_Nq1, IC);
+    gerar_intervalo_media(media_E_N1, var_E_N1, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_N1, media_E_N1, IC);
+    gerar_intervalo_media(media_E_W2, var_E_W2, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_W2, media_E_W2, IC);
+    gerar_intervalo_media(media_E_T2, var_E_T2, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_T2, media_E_T2, IC);
+    gerar_intervalo_media(media_E_Nq2, var_E_Nq2, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_Nq2, media_E_Nq2, IC);
+    gerar_intervalo_media(media_E_N2, var_E_N2, num_rodadas, IC);
+    preencher_intervalo(&resultado->E_N2, media_E_N2, IC);
     gerar_intervalo_variancia(media_V_W1, p_variancia, IC);
-    printf("V[W1]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_V_W1, IC[1], precisao_IC(IC)*100);
+    preencher_intervalo(&resultado->V_W1, media_V_W1, IC);
     gerar_intervalo_variancia(media_V_W2, p_variancia, IC);
-    printf("V[W2]: %f - %f - %f (p = %.2f%%)\n", IC[0], media_V_W2, IC[1], precisao_IC(IC)*100);
-    printf("\n\n");
+    preencher_intervalo(&resultado->V_W2, media_V_W2, IC);
+
+    resultado->coletas_rodada = rodadas[0].num_coletas;
+    resultado->num_rodadas = num_rodadas;
+    resultado->rodadas_independentes = rodadas_independentes(rodadas, num_rodadas);
+}
+
+/**
+ * Calcula os ICs das rodadas da simulação (sem a fase transiente) e preenche o `resultado`.
+ * No modo K automático, as rodadas são agrupadas antes por agrupar_rodadas()
+*/
+void calcular_IC_rodadas(const Simulacao *sim, ResultadoSimulacao *resultado) {
+    unsigned long num_rodadas = sim->parametros.num_rodadas;
+    MetricasRodada *metricas = malloc(sizeof(MetricasRodada) * num_rodadas);
+
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        metricas_rodada(sim, i + 1, &metricas[i]);
+    }
+    if (sim->parametros.k_automatico) {
+        num_rodadas = agrupar_rodadas(metricas, num_rodadas);
+    }
+    calcular_IC_metricas(metricas, num_rodadas, resultado);
+
+    free(metricas);
 }
 
-int main(int argc, char const *argv[])
+/**
+ * Uma trajetória da estimação por divisão. Guarda só o estado do sistema (gerador,
+ * eventos agendados e filas), sem métricas de rodadas, então copiar uma trajetória é barato
+*/
+typedef struct Trajetoria
 {
-    // marca o incio da simulação
-    time_t inicio = time(NULL);
-    
-    // Inicia as variáveis globais
-    fila1 = criar_fila();
-    fila2 = criar_fila();
-    rodadas_encerradas = 0ul;
-    iniciar_fase_transiente();
-    srand(SEED);
+    EstadoGerador gerador; // Gerador de números aleatórios da trajetória
+    Evento *evento_atual; // Evento sendo tratado, início da fila de eventos da trajetória
+    FilaEspera *fila1;
+    FilaEspera *fila2;
+    unsigned long nivel; // Número de limiares que N2 já atingiu
+} Trajetoria;
 
-    // Agenda a primeira chegada
-    evento_atual = criar_evento(amostra_exponencial(lambda), criar_cliente(fase_transiente), chegada_fila_1);
+/**
+ * Estado da estimação de P(W2 > t) por divisão de trajetórias (RESTART)
+*/
+typedef struct Divisao
+{
+    ParametrosDivisao parametros; // Parâmetros com os quais a estimação foi iniciada
 
-    // Realiza a simulação propriamente dita, agenda e processa os eventos
-    while(rodadas_encerradas < NUM_RODADAS+1) {
-        processar_evento_atual();
+    Trajetoria principal; // Trajetória que nunca morre e define os ciclos regenerativos
+
+    // Uma trajetória por nível para as cópias. As cópias são simuladas em
+    // profundidade, então há no máximo uma viva por nível, e os buffers das filas
+    // são reaproveitados de uma cópia para a outra
+    Trajetoria *copias;
 
-        Evento *temp = evento_atual;
-        evento_atual = evento_atual->prox_evento;
+    // pesos[i] = 1/fator_divisao^i é o peso de uma partida de uma trajetória no nível i,
+    // já que a região acima do i-ésimo limiar é simulada fator_divisao^i vezes
+    double *pesos;
+
+    double soma_ciclo; // Soma dos pesos das partidas com W2 > t no ciclo atual, em todas as trajetórias
+    unsigned long partidas_principal_ciclo; // Partidas com W2 > t da trajetória principal no ciclo atual
+    unsigned long clientes_ciclo; // Chegadas da trajetória principal no ciclo atual
+
+    unsigned long num_copias; // Número de cópias criadas
+    unsigned long num_eventos; // Número de eventos processados
+} Divisao;
+
+static void dividir_trajetoria(Divisao *div, Trajetoria *traj);
+
+/**
+ * Libera os eventos da fila de eventos que começa por `evento`
+*/
+static void destruir_eventos(Evento *evento) {
+    while (evento != NULL) {
+        Evento *temp = evento;
+        evento = temp->prox_evento;
         free(temp);
     }
+}
+
+/**
+ * Copia os clientes da fila `origem` para a fila `destino`, reaproveitando o
+ * buffer do `destino` se ele for grande o suficiente
+*/
+static void copiar_fila(FilaEspera *destino, const FilaEspera *origem) {
+    if (destino->capacidade < origem->num_clientes) {
+        free(destino->clientes);
+        destino->capacidade = origem->capacidade;
+        destino->clientes = malloc(sizeof(Cliente) * destino->capacidade);
+    }
+
+    // Desfaz a volta do buffer circular da origem
+    unsigned long num_ate_fim = origem->capacidade - origem->inicio;
+    if (num_ate_fim > origem->num_clientes) {
+        num_ate_fim = origem->num_clientes;
+    }
+    memcpy(destino->clientes, &origem->clientes[origem->inicio], sizeof(Cliente) * num_ate_fim);
+    memcpy(&destino->clientes[num_ate_fim], origem->clientes, sizeof(Cliente) * (origem->num_clientes - num_ate_fim));
+    destino->inicio = 0ul;
+    destino->num_clientes = origem->num_clientes;
+}
+
+/**
+ * Copia o estado da trajetória `origem` para a trajetória `destino`, que não deve ter
+ * eventos agendados. O gerador da cópia recebe uma semente tirada do gerador da
+ * `origem`, para que as duas trajetórias sigam caminhos diferentes a partir daqui
+*/
+static void copiar_trajetoria(Trajetoria *destino, Trajetoria *origem) {
+    uint64_t semente = (uint64_t) (amostra_uniforme(&origem->gerador) * 9007199254740992.0);
+    iniciar_gerador(&destino->gerador, origem->gerador.tipo, semente);
+
+    Evento **fim = &destino->evento_atual;
+    for (const Evento *e = origem->evento_atual; e != NULL; e = e->prox_evento) {
+        *fim = criar_evento(e->momento, e->tipo);
+        fim = &(*fim)->prox_evento;
+    }
+
+    copiar_fila(destino->fila1, origem->fila1);
+    copiar_fila(destino->fila2, origem->fila2);
+    destino->nivel = origem->nivel;
+}
+
+/**
+ * Retorna o nível da trajetória `traj`, o número de limiares menores ou iguais a N2
+*/
+static unsigned long nivel_trajetoria(const Divisao *div, const Trajetoria *traj) {
+    unsigned long N2 = traj->fila2->num_clientes;
+    if (N2 < div->parametros.limiar_inicial) return 0ul;
+
+    unsigned long nivel = (N2 - div->parametros.limiar_inicial)/div->parametros.passo_limiar + 1ul;
+    if (nivel > div->parametros.num_limiares) return div->parametros.num_limiares;
+    return nivel;
+}
+
+/**
+ * Inicia o serviço do primeiro cliente da fila 1 da trajetória `traj`,
+ * interrompendo o cliente da fila 2 em serviço (se houver algum)
+*/
+static void iniciar_servico_1_trajetoria(Divisao *div, Trajetoria *traj) {
+    double momento = traj->evento_atual->momento;
+
+    if (traj->fila2->num_clientes > 0ul && cancelar_partida(traj->evento_atual)) {
+        primeiro_cliente_fila(traj->fila2)->chegada_estado_atual = momento;
+    }
+
+    double termino_servico = momento + amostra_exponencial(&traj->gerador, div->parametros.taxa_servico);
+    agendar_evento(traj->evento_atual, termino_servico, chegada_fila_2);
+}
+
+/**
+ * Inicia o serviço do primeiro cliente da fila 2 da trajetória `traj`
+*/
+static void iniciar_servico_2_trajetoria(Divisao *div, Trajetoria *traj) {
+    double momento = traj->evento_atual->momento;
+    Cliente *cliente = primeiro_cliente_fila(traj->fila2);
+
+    cliente->W2 += momento - cliente->chegada_estado_atual;
+    cliente->chegada_estado_atual = momento;
+
+    double termino_servico = momento + amostra_exponencial(&traj->gerador, div->parametros.taxa_servico);
+    agendar_evento(traj->evento_atual, termino_servico, partida);
+}
+
+/**
+ * Realiza o tratamento do evento atual da trajetória `traj`. Segue a mesma dinâmica
+ * de processar_evento_atual(), mas só acompanha o W2 dos clientes
+*/
+static void processar_evento_trajetoria(Divisao *div, Trajetoria *traj) {
+    double momento = traj->evento_atual->momento;
+    Cliente cliente;
+
+    switch (traj->evento_atual->tipo)
+    {
+    case chegada_fila_1:
+        cliente.chegada_estado_atual = momento;
+        cliente.chegada_fila_atual = momento;
+        cliente.W2 = 0.0;
+        cliente.rodada = 0u;
+        cliente.indice_rodada = 0u;
+        adicionar_cliente_fila(traj->fila1, &cliente);
+        if (traj == &div->principal) {
+            div->clientes_ciclo += 1ul;
+        }
+
+        if (traj->fila1->num_clientes == 1ul) {
+            iniciar_servico_1_trajetoria(div, traj);
+        }
+
+        agendar_evento(traj->evento_atual, momento + amostra_exponencial(&traj->gerador, div->parametros.taxa_chegada), chegada_fila_1);
+        break;
 
-    // Imprime na tela os ICs coletados pela simulação.
-    // Os resultados são impressos no seguinte formato:
-    // [Métrica coletada]: [Limite inferior] - [média do IC] - [Limite superior]
-    calcular_IC_rodadas();
+    case chegada_fila_2:
+        cliente = prox_cliente_fila(traj->fila1);
+        cliente.chegada_fila_atual = momento;
+        cliente.chegada_estado_atual = momento;
+        adicionar_cliente_fila(traj->fila2, &cliente);
+
+        if (traj->fila1->num_clientes > 0ul) {
+            iniciar_servico_1_trajetoria(div, traj);
+        } else {
+            iniciar_servico_2_trajetoria(div, traj);
+        }
+        break;
 
-    // marca o final da simulação
-    time_t fim = time(NULL);
+    case partida:
+        // A partida é contada com o peso do nível em que a trajetória estava até ela
+        cliente = prox_cliente_fila(traj->fila2);
+        if (cliente.W2 > div->parametros.limite_W2) {
+            div->soma_ciclo += div->pesos[traj->nivel];
+            if (traj == &div->principal) {
+                div->partidas_principal_ciclo += 1ul;
+            }
+        }
 
-    // imprime o tempo da simulação na tela
-    printf("A simulação levou %ld segundos.\n", fim-inicio);
+        if (traj->fila2->num_clientes > 0ul) {
+            iniciar_servico_2_trajetoria(div, traj);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Processa o próximo evento da trajetória `traj` e atualiza o seu nível.
+ * Se a trajetória atingiu um novo limiar, ela é dividida
+*/
+static void avancar_trajetoria(Divisao *div, Trajetoria *traj) {
+    processar_evento_trajetoria(div, traj);
+
+    Evento *temp = traj->evento_atual;
+    traj->evento_atual = temp->prox_evento;
+    free(temp);
+    div->num_eventos += 1ul;
+
+    unsigned long nivel = nivel_trajetoria(div, traj);
+    if (nivel > traj->nivel) {
+        traj->nivel = nivel;
+        dividir_trajetoria(div, traj);
+    } else {
+        traj->nivel = nivel;
+    }
+}
+
+/**
+ * Cria e simula as fator_divisao-1 cópias da trajetória `traj`, que acabou de atingir
+ * o limiar do seu nível. Cada cópia é simulada até voltar para baixo desse limiar
+*/
+static void dividir_trajetoria(Divisao *div, Trajetoria *traj) {
+    unsigned long nivel = traj->nivel;
+    Trajetoria *copia = &div->copias[nivel - 1];
+
+    for (unsigned long i = 1ul; i < div->parametros.fator_divisao; i++) {
+        copiar_trajetoria(copia, traj);
+        div->num_copias += 1ul;
+
+        while (copia->nivel >= nivel) {
+            avancar_trajetoria(div, copia);
+        }
+
+        destruir_eventos(copia->evento_atual);
+        copia->evento_atual = NULL;
+    }
+}
+
+/**
+ * Preenche o `intervalo` de confiança do estimador regenerativo E[Y]/E[tau], onde
+ * Y[i] e tau[i] são as somas do ciclo i e `n` é o número de ciclos. Como os ciclos
+ * são independentes, r = somatorio Y / somatorio tau tem IC
+ * r +- Z*s/(media(tau)*sqrt(n)), onde s^2 é a variância amostral de Y[i] - r*tau[i]
+*/
+static void gerar_intervalo_razao(const double *Y, const double *tau, unsigned long n, IntervaloConfianca *intervalo) {
+    double soma_Y = 0.0;
+    double soma_tau = 0.0;
+    for (unsigned long i = 0ul; i < n; i++) {
+        soma_Y += Y[i];
+        soma_tau += tau[i];
+    }
+    double r = soma_Y/soma_tau;
+
+    double s2 = 0.0;
+    for (unsigned long i = 0ul; i < n; i++) {
+        s2 += (Y[i] - r*tau[i])*(Y[i] - r*tau[i]);
+    }
+    s2 /= (n-1);
+
+    double IC[2];
+    double valor_auxiliar = Z * sqrt(s2) / ((soma_tau/n) * sqrt(n));
+    IC[0] = r - valor_auxiliar;
+    IC[1] = r + valor_auxiliar;
+    preencher_intervalo(intervalo, r, IC);
+}
+
+/**
+ * Estima P(W2 > t) por divisão de trajetórias (RESTART) com os `parametros` fornecidos
+ * e preenche o `resultado`. Retorna 0 em caso de sucesso e -1 se os parâmetros forem inválidos.
+ *
+ * A trajetória principal começa com o sistema vazio, e cada chegada ao sistema vazio
+ * inicia um novo ciclo regenerativo. Quando uma trajetória atinge um limiar de N2,
+ * suas cópias são simuladas até voltarem para baixo do limiar, sempre dentro do ciclo
+ * em que foram criadas. Assim os ciclos são independentes, e P(W2 > t) é a razão entre
+ * a soma ponderada das partidas com W2 > t por ciclo e o número de clientes por ciclo.
+ * Com os pesos 1/fator_divisao^nivel o numerador tem a mesma esperança da simulação
+ * sem divisão, que é estimada junto pela trajetória principal sozinha
+*/
+int executar_divisao(const ParametrosDivisao *parametros, ResultadoDivisao *resultado) {
+    if (parametros->taxa_chegada <= 0.0 || parametros->taxa_servico <= 0.0 ||
+        (parametros->gerador != GERADOR_XORSHIFT && parametros->gerador != GERADOR_LCG48) ||
+        parametros->limite_W2 < 0.0 || parametros->limiar_inicial < 1ul ||
+        parametros->passo_limiar < 1ul || parametros->fator_divisao < 1ul ||
+        parametros->num_ciclos < 2ul) {
+        return -1;
+    }
+
+    Divisao div;
+    div.parametros = *parametros;
+    div.soma_ciclo = 0.0;
+    div.partidas_principal_ciclo = 0ul;
+    div.clientes_ciclo = 0ul;
+    div.num_copias = 0ul;
+    div.num_eventos = 0ul;
+
+    div.pesos = malloc(sizeof(double) * (parametros->num_limiares + 1));
+    div.pesos[0] = 1.0;
+    for (unsigned long i = 1ul; i <= parametros->num_limiares; i++) {
+        div.pesos[i] = div.pesos[i - 1] / parametros->fator_divisao;
+    }
+
+    div.copias = malloc(sizeof(Trajetoria) * parametros->num_limiares);
+    for (unsigned long i = 0ul; i < parametros->num_limiares; i++) {
+        div.copias[i].evento_atual = NULL;
+        div.copias[i].fila1 = criar_fila();
+        div.copias[i].fila2 = criar_fila();
+    }
+
+    Trajetoria *principal = &div.principal;
+    iniciar_gerador(&principal->gerador, parametros->gerador, (uint64_t) parametros->semente);
+    principal->fila1 = criar_fila();
+    principal->fila2 = criar_fila();
+    principal->nivel = 0ul;
+    principal->evento_atual = criar_evento(amostra_exponencial(&principal->gerador, parametros->taxa_chegada), chegada_fila_1);
+
+    // Somas de cada ciclo: partidas com W2 > t ponderadas, partidas com W2 > t
+    // da trajetória principal e clientes da trajetória principal
+    double *somas_ciclos = malloc(sizeof(double) * parametros->num_ciclos);
+    double *partidas_principal = malloc(sizeof(double) * parametros->num_ciclos);
+    double *clientes_ciclos = malloc(sizeof(double) * parametros->num_ciclos);
+    unsigned long clientes_principal = 0ul;
+
+    unsigned long ciclo = 0ul;
+    while (ciclo < parametros->num_ciclos) {
+        // Uma chegada ao sistema vazio encerra o ciclo atual (o sistema começa vazio,
+        // então a primeira chegada só inicia o primeiro ciclo)
+        if (principal->evento_atual->tipo == chegada_fila_1 && principal->fila1->num_clientes == 0ul &&
+            principal->fila2->num_clientes == 0ul && div.clientes_ciclo > 0ul) {
+            somas_ciclos[ciclo] = div.soma_ciclo;
+            partidas_principal[ciclo] = div.partidas_principal_ciclo;
+            clientes_ciclos[ciclo] = div.clientes_ciclo;
+            clientes_principal += div.clientes_ciclo;
+            ciclo += 1ul;
+
+            div.soma_ciclo = 0.0;
+            div.partidas_principal_ciclo = 0ul;
+            div.clientes_ciclo = 0ul;
+            continue;
+        }
+        avancar_trajetoria(&div, principal);
+    }
+
+    gerar_intervalo_razao(somas_ciclos, clientes_ciclos, parametros->num_ciclos, &resultado->P_W2);
+    gerar_intervalo_razao(partidas_principal, clientes_ciclos, parametros->num_ciclos, &resultado->P_W2_principal);
+    resultado->num_ciclos = parametros->num_ciclos;
+    resultado->clientes_principal = clientes_principal;
+    resultado->num_copias = div.num_copias;
+    resultado->num_eventos = div.num_eventos;
+
+    free(somas_ciclos);
+    free(partidas_principal);
+    free(clientes_ciclos);
+    destruir_eventos(principal->evento_atual);
+    destruir_fila(principal->fila1);
+    destruir_fila(principal->fila2);
+    for (unsigned long i = 0ul; i < parametros->num_limiares; i++) {
+        destruir_fila(div.copias[i].fila1);
+        destruir_fila(div.copias[i].fila2);
+    }
+    free(div.copias);
+    free(div.pesos);
 
     return 0;
-}
\ No newline at end of file
+}
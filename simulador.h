@@ -1,42 +1,145 @@
 #ifndef _SIMULADOR_H_
 #define _SIMULADOR_H_
 
-typedef struct Rodada Rodada;
-typedef struct Cliente Cliente;
-typedef struct FilaEspera FilaEspera;
-typedef enum tipo_evento TipoEvento;
-typedef struct Evento Evento;
-
-Rodada *criar_rodada();
-void iniciar_fase_transiente();
-void iniciar_nova_rodada();
-Cliente *criar_cliente(Rodada *rodada);
-FilaEspera *criar_fila();
-void adicionar_cliente_fila(FilaEspera *fila, Cliente *cliente);
-Cliente *prox_cliente_fila(FilaEspera *fila);
-Evento *criar_evento(double momento,Cliente *cliente, TipoEvento tipo);
-void agendar_evento(double momento, Cliente *cliente, TipoEvento tipo);
-double amostra_exponencial(double taxa);
-double variancia(double E_X, double *X);
-long get_Nq1();
-long get_N1();
-long get_Nq2();
-long get_N2();
-void atualizar_E_Nq1();
-void atualizar_E_N1();
-void atualizar_E_Nq2();
-void atualizar_E_N2();
-void processar_evento_atual();
-void processar_chegada_fila_1();
-void processar_chegada_fila_2();
-void processar_partida();
-void processar_chegada_servico_1();
-void processar_chegada_servico_2();
-void interromper_servico_fila_2();
-void encerrar_coleta(Rodada *rodada);
-void gerar_intervalo_media(double media, double variancia, int n, double * intervalo_confianca);
+#include "trace.h"
+
+// API reentrante do simulador. Todo o estado de uma simulação fica no seu
+// contexto (Simulacao), então várias simulações podem ser criadas e executadas
+// no mesmo processo. A biblioteca não faz nenhuma entrada/saída.
+
+typedef struct Simulacao Simulacao;
+
+// Geradores de números aleatórios disponíveis
+typedef enum gerador {
+    GERADOR_XORSHIFT = 0, // xorshift64*, o padrão
+    GERADOR_LCG48 // Congruencial linear de 48 bits (o mesmo do drand48)
+} Gerador;
+
+// Tipos de eventos agendáveis
+typedef enum tipo_evento {chegada_fila_1 = 0, chegada_fila_2, partida} TipoEvento;
+
+/**
+ * Parâmetros de uma simulação
+*/
+typedef struct ParametrosSimulacao
+{
+    double taxa_chegada; // Taxa de chegada de cada classe (lambda)
+    double taxa_servico; // Taxa de serviço (mu)
+    unsigned long coletas_rodada; // Número de coletas por rodada (K)
+    unsigned long coletas_transiente; // Número de coletas da fase transiente (K_t)
+    unsigned long num_rodadas; // Número de rodadas
+    unsigned long semente; // Semente da geração de números aleatórios
+    Gerador gerador; // Gerador de números aleatórios
+    int k_automatico; // Se != 0, agrupa rodadas adjacentes (dobrando K) até que as
+                      // médias das rodadas passem no teste de independência
+} ParametrosSimulacao;
+
+/**
+ * Métricas coletadas em uma rodada. Guarda também o número de coletas e a duração
+ * da rodada, o que permite juntar rodadas adjacentes sem simular novamente
+*/
+typedef struct MetricasRodada
+{
+    double E_W1; // E[W1]
+    double E_T1; // E[T1]
+    double E_Nq1; // E[Nq1]
+    double E_N1; // E[N1]
+    double E_W2; // E[W2]
+    double E_T2; // E[T2]
+    double E_Nq2; // E[Nq2]
+    double E_N2; // E[N2]
+    double V_W1; // V[W1]
+    double V_W2; // V[W2]
+
+    unsigned long num_coletas; // Número de clientes da rodada
+    double duracao; // Duração da rodada
+} MetricasRodada;
+
+/**
+ * Intervalo de confiança de uma métrica
+*/
+typedef struct IntervaloConfianca
+{
+    double inferior; // Limite inferior
+    double media; // Média das rodadas
+    double superior; // Limite superior
+    double precisao; // Precisão do intervalo (ver precisao_IC)
+} IntervaloConfianca;
+
+/**
+ * Intervalos de confiança de todas as métricas de uma simulação
+*/
+typedef struct ResultadoSimulacao
+{
+    IntervaloConfianca E_W1;
+    IntervaloConfianca E_T1;
+    IntervaloConfianca E_Nq1;
+    IntervaloConfianca E_N1;
+    IntervaloConfianca E_W2;
+    IntervaloConfianca E_T2;
+    IntervaloConfianca E_Nq2;
+    IntervaloConfianca E_N2;
+    IntervaloConfianca V_W1;
+    IntervaloConfianca V_W2;
+
+    unsigned long coletas_rodada; // Número de coletas por rodada usado nos ICs (o K escolhido no modo automático)
+    unsigned long num_rodadas; // Número de rodadas usado nos ICs
+    int rodadas_independentes; // Se as médias das rodadas passaram no teste de von Neumann
+} ResultadoSimulacao;
+
+/**
+ * Parâmetros da estimação de P(W2 > t) por divisão de trajetórias (RESTART).
+ * Os limiares são valores do número de clientes na fila 2 (N2), o i-ésimo é
+ * limiar_inicial + (i-1)*passo_limiar. Ao ultrapassar um limiar, a trajetória é
+ * dividida em fator_divisao cópias, e as cópias extras morrem ao voltar para baixo dele
+*/
+typedef struct ParametrosDivisao
+{
+    double taxa_chegada; // Taxa de chegada de cada classe (lambda)
+    double taxa_servico; // Taxa de serviço (mu)
+    double limite_W2; // O t de P(W2 > t)
+    unsigned long limiar_inicial; // N2 do primeiro limiar (>= 1)
+    unsigned long passo_limiar; // Distância entre limiares consecutivos (>= 1)
+    unsigned long num_limiares; // Número de limiares, 0 é a simulação sem divisão
+    unsigned long fator_divisao; // Número de cópias da trajetória em cada limiar (>= 1)
+    unsigned long num_ciclos; // Número de ciclos regenerativos (sistema vazio) simulados
+    unsigned long semente; // Semente da geração de números aleatórios
+    Gerador gerador; // Gerador de números aleatórios
+} ParametrosDivisao;
+
+/**
+ * Resultado da estimação de P(W2 > t) por divisão de trajetórias
+*/
+typedef struct ResultadoDivisao
+{
+    IntervaloConfianca P_W2; // IC de P(W2 > t) com as trajetórias divididas
+    IntervaloConfianca P_W2_principal; // IC de P(W2 > t) só com a trajetória principal (simulação sem divisão)
+
+    unsigned long num_ciclos; // Número de ciclos regenerativos
+    unsigned long clientes_principal; // Número de clientes da trajetória principal
+    unsigned long num_copias; // Número de cópias de trajetórias criadas
+    unsigned long num_eventos; // Número de eventos processados em todas as trajetórias
+} ResultadoDivisao;
+
+Simulacao *criar_simulacao(const ParametrosSimulacao *parametros);
+Simulacao *criar_reproducao(const ParametrosSimulacao *parametros);
+void destruir_simulacao(Simulacao *sim);
+int simulacao_encerrada(const Simulacao *sim);
+void processar_prox_evento(Simulacao *sim, RegistroTrace *registro);
+int reproduzir_registro(Simulacao *sim, const RegistroTrace *registro);
+unsigned long num_rodadas_encerradas(const Simulacao *sim);
+void metricas_rodada(const Simulacao *sim, unsigned long indice, MetricasRodada *metricas);
+void calcular_IC_rodadas(const Simulacao *sim, ResultadoSimulacao *resultado);
+int executar_simulacao(const ParametrosSimulacao *parametros, ResultadoSimulacao *resultado);
+int executar_divisao(const ParametrosDivisao *parametros, ResultadoDivisao *resultado);
+
+void gerar_intervalo_media(double media, double variancia, int n, double *intervalo_confianca);
 void gerar_intervalo_variancia(double variancia, double precisao, double *intervalo_confianca);
 double precisao_IC(double *intervalo_confianca);
-void calcular_IC_rodadas();
+double precisao_intervalo_variancia(unsigned long num_rodadas);
+void juntar_rodadas(const MetricasRodada *a, const MetricasRodada *b, MetricasRodada *juncao);
+int rodadas_independentes(const MetricasRodada *rodadas, unsigned long num_rodadas);
+unsigned long agrupar_rodadas(MetricasRodada *rodadas, unsigned long num_rodadas);
+void calcular_IC_metricas(const MetricasRodada *rodadas, unsigned long num_rodadas, ResultadoSimulacao *resultado);
 
-#endif
\ No newline at end of file
+#endif
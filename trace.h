@@ -0,0 +1,43 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+
+// Formato binário do trace de eventos gravado pelo simulador e lido pelo replay.
+// O arquivo é composto por um CabecalhoTrace seguido de num_eventos RegistroTrace,
+// na ordem em que os eventos foram processados.
+
+#define ASSINATURA_TRACE "SIMTRACE" // Assinatura no início de todo arquivo de trace
+#define VERSAO_TRACE 2u // Versão do formato do trace
+
+/**
+ * Cabeçalho do arquivo de trace, guarda a configuração da simulação que o gerou
+*/
+typedef struct CabecalhoTrace
+{
+    char assinatura[8]; // ASSINATURA_TRACE, sem o '\0'
+    uint32_t versao; // VERSAO_TRACE
+    uint32_t tamanho_registro; // sizeof(RegistroTrace)
+
+    double taxa_chegada; // Taxa de chegada de cada classe
+    double taxa_servico; // Taxa de serviço
+
+    uint64_t coletas_rodada; // Número de coletas por rodada
+    uint64_t coletas_transiente; // Número de coletas da fase transiente
+    uint64_t num_rodadas; // Número de rodadas
+    uint64_t semente; // Semente da geração de números aleatórios
+    uint64_t num_eventos; // Número de registros que seguem o cabeçalho
+} CabecalhoTrace;
+
+/**
+ * Um evento processado pelo simulador
+*/
+typedef struct RegistroTrace
+{
+    double momento; // Momento em que o evento foi tratado
+    uint64_t id_cliente; // Ordem de chegada do cliente ao qual o evento se refere
+    uint32_t tipo; // Tipo do evento (TipoEvento)
+    uint32_t reservado; // Sempre 0, completa o alinhamento do registro
+} RegistroTrace;
+
+#endif
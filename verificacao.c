@@ -0,0 +1,115 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulador.h"
+
+// Verifica que juntar_rodadas() é exato: a sequência de eventos não depende de K
+// (as rodadas só mudam a contabilidade), então com a mesma semente e o mesmo K_t,
+// juntar as rodadas i e i+1 de uma simulação com K deve dar a rodada (i+1)/2 de
+// uma simulação com 2K, a menos de arredondamento.
+//
+// Uso: ./verificacao (ou make verificar). Retorna 0 se todas as verificações passarem.
+
+#define SEED 358141284 // Semente das simulações
+#define mu 1.0 // Taxa de serviço
+#define NUM_RODADAS 200ul // Número de rodadas com 2K comparadas
+#define TOLERANCIA 1e-9 // Maior diferença relativa aceita entre as métricas
+
+// Configurações verificadas
+#define NUM_CONFIGURACOES 4
+const double rhos[NUM_CONFIGURACOES] = {0.2, 0.6, 0.6, 0.9};
+const unsigned long Ks[NUM_CONFIGURACOES] = {10ul, 10ul, 75ul, 500ul};
+const unsigned long K_ts[NUM_CONFIGURACOES] = {40ul, 300ul, 300ul, 9000ul};
+
+#define NUM_METRICAS 10
+const char *nomes_metricas[NUM_METRICAS] = {
+    "E[W1]", "E[T1]", "E[Nq1]", "E[N1]", "E[W2]", "E[T2]", "E[Nq2]", "E[N2]", "V[W1]", "V[W2]"
+};
+
+/**
+ * Simula com os parâmetros fornecidos e preenche `metricas` com as `num_rodadas` rodadas
+*/
+void simular_rodadas(double rho, unsigned long K, unsigned long K_t, unsigned long num_rodadas, MetricasRodada *metricas) {
+    ParametrosSimulacao parametros = {
+        .taxa_chegada = rho*mu/2.0,
+        .taxa_servico = mu,
+        .coletas_rodada = K,
+        .coletas_transiente = K_t,
+        .num_rodadas = num_rodadas,
+        .semente = SEED,
+        .gerador = GERADOR_XORSHIFT
+    };
+    Simulacao *sim = criar_simulacao(&parametros);
+    while (!simulacao_encerrada(sim)) {
+        processar_prox_evento(sim, NULL);
+    }
+    for (unsigned long i = 0ul; i < num_rodadas; i++) {
+        metricas_rodada(sim, i + 1, &metricas[i]);
+    }
+    destruir_simulacao(sim);
+}
+
+/**
+ * Retorna a diferença relativa entre `a` e `b`
+*/
+double diferenca_relativa(double a, double b) {
+    double escala = fmax(fabs(a), fabs(b));
+    return (escala == 0.0) ? 0.0 : fabs(a - b)/escala;
+}
+
+/**
+ * Compara a `juncao` de duas rodadas com K com a `rodada` simulada com 2K.
+ * Imprime as métricas que diferem e retorna o número delas
+*/
+int comparar_rodadas(const MetricasRodada *juncao, const MetricasRodada *rodada, unsigned long indice) {
+    const double valores_juncao[NUM_METRICAS] = {
+        juncao->E_W1, juncao->E_T1, juncao->E_Nq1, juncao->E_N1, juncao->E_W2,
+        juncao->E_T2, juncao->E_Nq2, juncao->E_N2, juncao->V_W1, juncao->V_W2
+    };
+    const double valores_rodada[NUM_METRICAS] = {
+        rodada->E_W1, rodada->E_T1, rodada->E_Nq1, rodada->E_N1, rodada->E_W2,
+        rodada->E_T2, rodada->E_Nq2, rodada->E_N2, rodada->V_W1, rodada->V_W2
+    };
+
+    int falhas = 0;
+    for (int m = 0; m < NUM_METRICAS; m++) {
+        if (diferenca_relativa(valores_juncao[m], valores_rodada[m]) > TOLERANCIA) {
+            printf("  rodada %lu, %s: junção %.12f, 2K %.12f\n",
+                   indice, nomes_metricas[m], valores_juncao[m], valores_rodada[m]);
+            falhas += 1;
+        }
+    }
+    if (juncao->num_coletas != rodada->num_coletas ||
+        diferenca_relativa(juncao->duracao, rodada->duracao) > TOLERANCIA) {
+        printf("  rodada %lu: número de coletas ou duração diferentes\n", indice);
+        falhas += 1;
+    }
+    return falhas;
+}
+
+int main(int argc, char const *argv[])
+{
+    MetricasRodada *rodadas_K = malloc(sizeof(MetricasRodada) * 2 * NUM_RODADAS);
+    MetricasRodada *rodadas_2K = malloc(sizeof(MetricasRodada) * NUM_RODADAS);
+    int total_falhas = 0;
+
+    for (int c = 0; c < NUM_CONFIGURACOES; c++) {
+        simular_rodadas(rhos[c], Ks[c], K_ts[c], 2 * NUM_RODADAS, rodadas_K);
+        simular_rodadas(rhos[c], 2 * Ks[c], K_ts[c], NUM_RODADAS, rodadas_2K);
+
+        int falhas = 0;
+        for (unsigned long i = 0ul; i < NUM_RODADAS; i++) {
+            MetricasRodada juncao;
+            juntar_rodadas(&rodadas_K[2*i], &rodadas_K[2*i + 1], &juncao);
+            falhas += comparar_rodadas(&juncao, &rodadas_2K[i], i + 1);
+        }
+
+        printf("rho = %.1f, K = %lu -> 2K = %lu: %s\n", rhos[c], Ks[c], 2 * Ks[c], falhas ? "FALHOU" : "ok");
+        total_falhas += falhas;
+    }
+
+    free(rodadas_K);
+    free(rodadas_2K);
+    return (total_falhas == 0) ? 0 : 1;
+}